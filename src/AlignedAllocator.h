@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+/// @file AlignedAllocator.h
+/// Minimal std::allocator replacement that returns over-aligned storage.
+///
+/// Used for the structure-of-arrays particle buffers so each array starts on
+/// a cache-line boundary: vector loads never split a line, and the compiler
+/// can assume aligned access in the hot loops.
+///
+/// **Usage:**
+/// ```
+/// std::vector<float, AlignedAllocator<float, 64>> xs(n);
+/// ```
+template <typename T, std::size_t Alignment = 64>
+struct AlignedAllocator
+{
+    static_assert(Alignment >= alignof(T), "Alignment must satisfy the type's own alignment");
+    static_assert((Alignment & (Alignment - 1)) == 0, "Alignment must be a power of two");
+
+    using value_type = T;
+
+    template <typename U>
+    struct rebind { using other = AlignedAllocator<U, Alignment>; };
+
+    AlignedAllocator() noexcept = default;
+
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+    T* allocate(std::size_t n)
+    {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    }
+
+    void deallocate(T* p, std::size_t) noexcept
+    {
+        ::operator delete(p, std::align_val_t(Alignment));
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const noexcept { return true; }
+
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const noexcept { return false; }
+};
@@ -0,0 +1,106 @@
+#include "AllocCounter.h"
+
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+#if CLOTHSIM_ALLOC_COUNTER
+namespace
+{
+    std::atomic<std::uint64_t> totalCount{ 0 };
+    thread_local std::uint64_t threadCount = 0;
+
+    inline void count()
+    {
+        ++threadCount;
+        totalCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void* allocate(std::size_t size)
+    {
+        count();
+        // malloc(0) may return nullptr; new must not
+        if (void* p = std::malloc(size ? size : 1))
+            return p;
+        throw std::bad_alloc();
+    }
+
+    void* allocateAligned(std::size_t size, std::size_t alignment)
+    {
+        count();
+        // aligned_alloc wants a multiple of the alignment
+        size = (size + alignment - 1) / alignment * alignment;
+#if defined(_WIN32)
+        void* p = _aligned_malloc(size ? size : alignment, alignment);
+#else
+        void* p = std::aligned_alloc(alignment, size ? size : alignment);
+#endif
+        if (!p) throw std::bad_alloc();
+        return p;
+    }
+
+    void freeAligned(void* p) noexcept
+    {
+#if defined(_WIN32)
+        _aligned_free(p);
+#else
+        std::free(p);
+#endif
+    }
+}
+
+// MARK: Replacement operators
+void* operator new(std::size_t size)   { return allocate(size); }
+void* operator new[](std::size_t size) { return allocate(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    try { return allocate(size); } catch (...) { return nullptr; }
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    try { return allocate(size); } catch (...) { return nullptr; }
+}
+void* operator new(std::size_t size, std::align_val_t a)   { return allocateAligned(size, (std::size_t)a); }
+void* operator new[](std::size_t size, std::align_val_t a) { return allocateAligned(size, (std::size_t)a); }
+void* operator new(std::size_t size, std::align_val_t a, const std::nothrow_t&) noexcept
+{
+    try { return allocateAligned(size, (std::size_t)a); } catch (...) { return nullptr; }
+}
+void* operator new[](std::size_t size, std::align_val_t a, const std::nothrow_t&) noexcept
+{
+    try { return allocateAligned(size, (std::size_t)a); } catch (...) { return nullptr; }
+}
+
+void operator delete(void* p) noexcept                        { std::free(p); }
+void operator delete[](void* p) noexcept                      { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept          { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept        { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept   { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept               { freeAligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept             { freeAligned(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept  { freeAligned(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept   { freeAligned(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { freeAligned(p); }
+
+// MARK: Counters
+namespace AllocCounter
+{
+std::uint64_t total()  { return totalCount.load(std::memory_order_relaxed); }
+std::uint64_t thread() { return threadCount; }
+}
+#endif
+
+namespace AllocCounter
+{
+bool expectNone(std::uint64_t count, const char* what)
+{
+    if (count == 0) return true;
+    std::cerr << "✗ " << what << ": " << count << " heap allocation(s) in steady state\n";
+    assert(!"steady-state heap allocation");
+    return false;
+}
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+
+/// @file AllocCounter.h
+/// Debug count of heap allocations, to check that steady-state simulation
+/// steps and render frames allocate nothing.
+///
+/// **Counting:**
+/// AllocCounter.cpp replaces the global operator new (every form: array,
+/// aligned, nothrow), so every allocation made through new, the standard
+/// containers and std::function is counted, per thread and in total.
+/// malloc() is not counted: Dear ImGui and the GL driver allocate through
+/// it, and neither is ours to fix.
+///
+/// **Checking:**
+/// A Scope counts allocations from its construction: the calling thread's,
+/// or every thread's (which includes pool workers, but also anything else
+/// running at the time). expectNone(count, what) reports a non-zero count
+/// on std::cerr and, in builds without NDEBUG, asserts. The viewer checks
+/// the upload and draw of every frame and each simulation batch once
+/// commands have been quiet for a few batches; clothsim_headless
+/// --check-allocs checks every step after the first.
+///
+/// **Cost:**
+/// A thread-local and a relaxed atomic increment per allocation, so it is
+/// compiled into Debug configurations only (-DCLOTHSIM_ALLOC_COUNTER=ON,
+/// the default; without CMake, builds without NDEBUG). Release builds and
+/// OFF keep the standard operator new and make the functions below inline
+/// no-ops that report 0.
+
+#ifndef CLOTHSIM_ALLOC_COUNTER
+#ifdef NDEBUG
+#define CLOTHSIM_ALLOC_COUNTER 0
+#else
+#define CLOTHSIM_ALLOC_COUNTER 1
+#endif
+#endif
+
+namespace AllocCounter
+{
+#if CLOTHSIM_ALLOC_COUNTER
+    /// Allocations by every thread since start-up.
+    std::uint64_t total();
+
+    /// Allocations by the calling thread since it started.
+    std::uint64_t thread();
+#else
+    inline std::uint64_t total()  { return 0; }
+    inline std::uint64_t thread() { return 0; }
+#endif
+
+    /// Allocations since construction, by the calling thread or by all.
+    class Scope
+    {
+    public:
+        explicit Scope(bool allThreads = false) : all(allThreads), start(now()) {}
+        std::uint64_t count() const { return now() - start; }
+        void          restart()     { start = now(); }
+
+    private:
+        std::uint64_t now() const { return all ? total() : thread(); }
+
+        bool          all;
+        std::uint64_t start;
+    };
+
+    /// Report (and assert, without NDEBUG) a non-zero allocation count.
+    /// what names the checked work in the message. Returns true if zero.
+    bool expectNone(std::uint64_t count, const char* what);
+}
@@ -0,0 +1,188 @@
+#include "Ccd.h"
+#include "TriangleBvh.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // Small double-precision helpers: the cubic coefficients are products
+    // of three differences and lose most of their bits in float.
+    struct D3 { double x, y, z; };
+
+    D3 sub(const glm::vec3& a, const glm::vec3& b) { return { (double)a.x - b.x, (double)a.y - b.y, (double)a.z - b.z }; }
+    D3 add(const D3& a, const D3& b)   { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+    double dot(const D3& a, const D3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+    D3 cross(const D3& a, const D3& b)
+    {
+        return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+    }
+
+    struct Cubic
+    {
+        double c3, c2, c1, c0;
+        double operator()(double t) const { return ((c3 * t + c2) * t + c1) * t + c0; }
+    };
+
+    /// True if x3 starts within eps of the plane spanned by x1, x2, i.e.
+    /// |f(0)| < eps · |x1 × x2|: the pair is already in contact (or the
+    /// motion is degenerate) and is left to the discrete passes.
+    bool startsCoplanar(const Cubic& f, const D3& x1, const D3& x2, float eps)
+    {
+        D3     n  = cross(x1, x2);
+        double nn = dot(n, n);
+        return f.c0 * f.c0 <= (double)eps * eps * nn;
+    }
+
+    /// f(t) = (x1(t) × x2(t)) · x3(t) with x_i(t) = x_i + t v_i
+    Cubic coplanarity(const D3& x1, const D3& v1, const D3& x2, const D3& v2, const D3& x3, const D3& v3)
+    {
+        D3 x12  = cross(x1, x2);
+        D3 mix  = add(cross(v1, x2), cross(x1, v2));
+        D3 v12  = cross(v1, v2);
+        return { dot(v12, v3),
+                 dot(v12, x3) + dot(mix, v3),
+                 dot(mix, x3) + dot(x12, v3),
+                 dot(x12, x3) };
+    }
+
+    /// Roots of f in [0, 1], ascending. Returns the count (at most 3).
+    int roots01(const Cubic& f, double roots[3])
+    {
+        // Split [0, 1] at the critical points so f is monotone on each piece
+        double bounds[4];
+        int    nb = 0;
+        bounds[nb++] = 0.0;
+        double a = 3.0 * f.c3, b = 2.0 * f.c2, c = f.c1;
+        if (std::abs(a) > 1e-300)
+        {
+            double disc = b * b - 4.0 * a * c;
+            if (disc >= 0.0)
+            {
+                double sq = std::sqrt(disc);
+                double t1 = (-b - sq) / (2.0 * a);
+                double t2 = (-b + sq) / (2.0 * a);
+                if (t1 > t2) std::swap(t1, t2);
+                if (t1 > 0.0 && t1 < 1.0) bounds[nb++] = t1;
+                if (t2 > 0.0 && t2 < 1.0 && t2 != t1) bounds[nb++] = t2;
+            }
+        }
+        else if (std::abs(b) > 1e-300)
+        {
+            double t1 = -c / b;
+            if (t1 > 0.0 && t1 < 1.0) bounds[nb++] = t1;
+        }
+        bounds[nb++] = 1.0;
+
+        int count = 0;
+        for (int k = 0; k + 1 < nb; ++k)
+        {
+            double lo = bounds[k], hi = bounds[k + 1];
+            double flo = f(lo), fhi = f(hi);
+            if (flo == 0.0) { if (count == 0 || roots[count - 1] != lo) roots[count++] = lo; continue; }
+            if (flo * fhi > 0.0) continue;
+
+            for (int iter = 0; iter < 48; ++iter)
+            {
+                double mid  = 0.5 * (lo + hi);
+                double fmid = f(mid);
+                if ((fmid < 0.0) == (flo < 0.0)) { lo = mid; flo = fmid; }
+                else                              hi = mid;
+            }
+            roots[count++] = 0.5 * (lo + hi);
+            if (count == 3) break;
+        }
+        return count;
+    }
+
+    /// Motion of (y - x) over the step: (y1 - y0) - (x1 - x0)
+    D3 relativeMotion(const glm::vec3& y0, const glm::vec3& y1, const glm::vec3& x0, const glm::vec3& x1)
+    {
+        D3 dy = sub(y1, y0), dx = sub(x1, x0);
+        return { dy.x - dx.x, dy.y - dx.y, dy.z - dx.z };
+    }
+
+    glm::vec3 lerp(const glm::vec3& x0, const glm::vec3& x1, float t) { return x0 + (x1 - x0) * t; }
+}
+
+namespace Ccd
+{
+    bool vertexTriangle(const glm::vec3& p0, const glm::vec3& p1,
+                        const glm::vec3& a0, const glm::vec3& a1,
+                        const glm::vec3& b0, const glm::vec3& b1,
+                        const glm::vec3& c0, const glm::vec3& c1,
+                        float eps, float& toi)
+    {
+        D3 x1 = sub(b0, a0), x2 = sub(c0, a0);
+        Cubic f = coplanarity(x1, relativeMotion(b0, b1, a0, a1),
+                              x2, relativeMotion(c0, c1, a0, a1),
+                              sub(p0, a0), relativeMotion(p0, p1, a0, a1));
+        if (startsCoplanar(f, x1, x2, eps)) return false;
+
+        double roots[3];
+        int    count = roots01(f, roots);
+        for (int k = 0; k < count; ++k)
+        {
+            float t = (float)roots[k];
+            if (t < MIN_TOI) continue;
+            glm::vec3 p = lerp(p0, p1, t);
+            glm::vec3 q = TriangleBvh::closestPointOnTriangle(p, lerp(a0, a1, t), lerp(b0, b1, t), lerp(c0, c1, t));
+            glm::vec3 d = p - q;
+            if (glm::dot(d, d) < eps * eps) { toi = t; return true; }
+        }
+        return false;
+    }
+
+    bool edgeEdge(const glm::vec3& a0, const glm::vec3& a1,
+                  const glm::vec3& b0, const glm::vec3& b1,
+                  const glm::vec3& c0, const glm::vec3& c1,
+                  const glm::vec3& d0, const glm::vec3& d1,
+                  float eps, float& toi)
+    {
+        D3 x1 = sub(b0, a0);
+        Cubic f = coplanarity(x1, relativeMotion(b0, b1, a0, a1),
+                              sub(c0, a0), relativeMotion(c0, c1, a0, a1),
+                              sub(d0, a0), relativeMotion(d0, d1, a0, a1));
+        if (startsCoplanar(f, x1, sub(d0, c0), eps)) return false;
+
+        double roots[3];
+        int    count = roots01(f, roots);
+        for (int k = 0; k < count; ++k)
+        {
+            float t = (float)roots[k];
+            if (t < MIN_TOI) continue;
+            if (segmentDistSq(lerp(a0, a1, t), lerp(b0, b1, t), lerp(c0, c1, t), lerp(d0, d1, t)) < eps * eps)
+            {
+                toi = t;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    float segmentDistSq(const glm::vec3& p, const glm::vec3& q,
+                        const glm::vec3& r, const glm::vec3& s)
+    {
+        glm::vec3 d1 = q - p, d2 = s - r, w = p - r;
+        float a = glm::dot(d1, d1), e = glm::dot(d2, d2), f = glm::dot(d2, w);
+        float u, v;
+        if (a <= 1e-12f && e <= 1e-12f) { u = v = 0.f; }
+        else if (a <= 1e-12f)           { u = 0.f; v = glm::clamp(f / e, 0.f, 1.f); }
+        else
+        {
+            float c = glm::dot(d1, w);
+            if (e <= 1e-12f) { v = 0.f; u = glm::clamp(-c / a, 0.f, 1.f); }
+            else
+            {
+                float b     = glm::dot(d1, d2);
+                float denom = a * e - b * b;
+                u = denom > 0.f ? glm::clamp((b * f - c * e) / denom, 0.f, 1.f) : 0.f;
+                v = (b * u + f) / e;
+                if      (v < 0.f) { v = 0.f; u = glm::clamp(-c / a, 0.f, 1.f); }
+                else if (v > 1.f) { v = 1.f; u = glm::clamp((b - c) / a, 0.f, 1.f); }
+            }
+        }
+        glm::vec3 diff = (p + d1 * u) - (r + d2 * v);
+        return glm::dot(diff, diff);
+    }
+}
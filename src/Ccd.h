@@ -0,0 +1,47 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+/// @file Ccd.h
+/// Continuous collision tests for primitives moving linearly over a step.
+///
+/// Every point moves x(t) = x0 + t (x1 - x0) for t in [0, 1]. Four points
+/// can only meet as a vertex–triangle or edge–edge contact at a time when
+/// they are coplanar (Provot 1997; Bridson et al. 2002):
+/// ```
+/// f(t) = ((x_b - x_a) × (x_c - x_a)) · (x_d - x_a) = 0
+/// ```
+/// f is a cubic in t. Its roots in [0, 1] are found by splitting the interval
+/// at the roots of f' (so f is monotone on each piece) and bisecting every
+/// piece with a sign change, in double precision. Each root, earliest first,
+/// is then checked with a distance test at that time: a root is a hit if
+/// the primitives are closer than `eps` there.
+///
+/// Roots at t < MIN_TOI are ignored: the primitives touch at the start of
+/// the step already, and reporting them would pin the pair in place
+/// forever instead of letting the discrete passes separate it.
+namespace Ccd
+{
+    constexpr float MIN_TOI = 1e-6f;
+
+    /// Earliest time point p hits triangle (a, b, c).
+    /// @param toi Set to the time of impact in (0, 1] on a hit
+    bool vertexTriangle(const glm::vec3& p0, const glm::vec3& p1,
+                        const glm::vec3& a0, const glm::vec3& a1,
+                        const glm::vec3& b0, const glm::vec3& b1,
+                        const glm::vec3& c0, const glm::vec3& c1,
+                        float eps, float& toi);
+
+    /// Earliest time segment (a, b) hits segment (c, d).
+    /// @param toi Set to the time of impact in (0, 1] on a hit
+    bool edgeEdge(const glm::vec3& a0, const glm::vec3& a1,
+                  const glm::vec3& b0, const glm::vec3& b1,
+                  const glm::vec3& c0, const glm::vec3& c1,
+                  const glm::vec3& d0, const glm::vec3& d1,
+                  float eps, float& toi);
+
+    /// Squared distance between segments (p, q) and (r, s)
+    /// (Ericson, Real-Time Collision Detection §5.1.9).
+    float segmentDistSq(const glm::vec3& p, const glm::vec3& q,
+                        const glm::vec3& r, const glm::vec3& s);
+}
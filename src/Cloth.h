@@ -2,9 +2,19 @@
 
 #include "Constants.h"
 #include "Particle.h"
+#include "ParticleSoA.h"
 #include "Spring.h"
+#include "Collider.h"
+#include "MultigridStretch.h"
+#include "SpatialHash.h"
+#include "SleepTracker.h"
+#include "SparseSolver.h"
+#include "ThreadPool.h"
 
 #include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
 #include <vector>
 
 /// @file Cloth.h
@@ -16,14 +26,140 @@
 /// - Integration: Verlet (4th-order accurate, unconditionally stable)
 /// - Constraints: max-stretch enforcement via iterative constraint solving
 ///
+/// **Storage:**
+/// Particle state lives in a structure-of-arrays store (ParticleSoA) so the
+/// per-particle loops stream only the fields they touch. getParticles()
+/// returns an AoS view that is gathered on demand for the renderer.
+///
+/// **Layout:**
+/// Store slots follow particleLayout (tiled by default), not the grid.
+/// particleIndex(row, col) maps grid coordinates to a slot; getParticles(),
+/// ClothSnapshot and the OBJ export hand out grid order. Springs are sorted
+/// by (type, colour, endpoint a, endpoint b), so each colour batch walks
+/// the store in slot order.
+///
+/// **Sleeping:**
+/// With sleepEnabled, the store is also split into sleep tiles (the 8×8
+/// layout tiles, or bands of 8 rows in RowMajor). A tile whose particles
+/// all kept a mean speed below sleepSpeed for sleepSteps steps, while its
+/// neighbours did too, is frozen: its particles skip forces, integration,
+/// collider tests and constraint projection, and act as pinned for the
+/// springs to awake tiles. See update() for what wakes a tile. The tiles
+/// and the awake lists the phases walk live in SleepTracker.
+///
+/// **Checkpoints:**
+/// saveState() packs everything a later update() reads into a flat binary
+/// blob: grid size, LOD level and layout, every particle's position, previous
+/// position, velocity, mass and inverse mass (pins included), the springs,
+/// the parameters, globalTime and the last step length, plus the implicit
+/// solver's warm start. restoreState() rebuilds the cloth at the blob's grid
+/// and overwrites that state, so stepping on from a restore gives the same
+/// results as stepping on from the save. Not included: colliders (scene
+/// setup, owned by the caller) and sleep counters (every tile wakes).
+///
+/// **Level of detail:**
+/// setLodLevel(L) simulates on a coarser grid (ClothLod::gridSize(), about
+/// half the cells across per level) with the same physical extent, while
+/// the rows/cols given to the constructor or resize() stay the display
+/// grid that ClothSnapshot upsamples to. Switching levels resamples the
+/// positions, previous positions and velocities onto the new grid and
+/// moves each pin to the nearest new grid point, so the motion carries on.
+/// Springs are rebuilt on the new rest grid, and particle mass stays per
+/// particle. getRows()/getCols()/getSpacing() are always the simulated
+/// grid.
+///
 /// **Update Loop (per frame):**
 /// 1. applyForces() — accumulate gravity, spring forces, damping, wind
 /// 2. integrate()  — update positions via Verlet, recover velocities
 /// 3. satisfyConstraints() — enforce spring length limits (prevents explosion)
 ///
+/// With solverMode = SolverMode::XPBD the loop is instead xpbdSubsteps
+/// repetitions of external forces → integrate(h) → solveXPBD(h).
+/// With SolverMode::Implicit, steps 1–2 are replaced by integrateImplicit().
+///
 /// **Key Reference:**
 /// Matt Fisher's Cloth Tutorial: https://graphics.stanford.edu/~mdfisher/cloth.html
 
+/// How applyForces() accumulates spring forces.
+enum class ForceMode
+{
+    /// Single-threaded scatter: each spring adds to both endpoints.
+    Serial,
+    /// Parallel two-pass gather: per-spring forces, then each particle sums
+    /// its incident springs from the CSR adjacency. Race-free, deterministic.
+    ParallelGather
+};
+
+/// Features the spring kernels of applyForces(), satisfyConstraints() and
+/// solveXPBD() are compiled for. Every combination is its own template
+/// instantiation, picked when the parameters, pins or sleep state change,
+/// so a kernel built without a feature has no code (or branch) for it and
+/// keeps its constants in registers. See Cloth::getKernelFeatures().
+enum KernelFeature : unsigned
+{
+    KernelDamping = 1u << 0,   ///< springDamping != 0: axial damping term
+    KernelSleep   = 1u << 1,   ///< Some tiles sleep: skip their springs, index through the awake list
+    KernelPins    = 1u << 2,   ///< Inverse masses differ (pins, sleep): corrections split by weight
+    KernelAll     = (1u << 3) - 1
+};
+
+struct SpringKernelArgs;
+
+/// Order of particles in the SoA store, chosen at construction / reset().
+enum class ParticleLayout
+{
+    /// slot = row * cols + col
+    RowMajor,
+    /// 8×8 tiles in row-major tile order, row-major inside each tile. A
+    /// particle's structural, shear and bending neighbours mostly share its
+    /// tile, so spring loops stay within a few cache lines per array.
+    Tiled
+};
+
+/// Time integration scheme used by Cloth::update().
+enum class SolverMode
+{
+    /// Explicit Hooke springs + Verlet, then constraintIters clamp passes.
+    MassSpring,
+    /// Extended Position-Based Dynamics, "small steps": xpbdSubsteps
+    /// substeps of dt / xpbdSubsteps, each one Verlet predict plus a single
+    /// compliant constraint sweep. Compliance is 1 / stiffness.
+    XPBD,
+    /// Baraff–Witkin backward Euler (integrateImplicit()), then
+    /// constraintIters clamp passes. Stable for stiff springs at large dt.
+    Implicit
+};
+
+/// Copy of the tunable parameters of a Cloth, passed around as one value
+/// (e.g. from the UI thread to the simulation thread). Field meanings and
+/// ranges are documented on the matching Cloth members.
+struct ClothParams
+{
+    glm::vec3 gravity         = DEFAULT_GRAVITY;
+    float     airDamping      = DEFAULT_AIR_DAMPING;
+    float     springStiffness = DEFAULT_SPRING_STIFFNESS;
+    float     bendStiffness   = DEFAULT_BEND_STIFFNESS;
+    float     springDamping   = DEFAULT_SPRING_DAMPING;
+    float     maxStretch      = DEFAULT_MAX_STRETCH;
+    float     maxCompress     = DEFAULT_MAX_COMPRESS;
+    int       constraintIters = DEFAULT_CONSTRAINT_ITERS;
+    float     constraintTolerance = DEFAULT_CONSTRAINT_TOLERANCE;
+    bool      multigridConstraints = false;
+    bool      windEnabled     = false;
+    float     windStrength    = DEFAULT_WIND_STRENGTH;
+    glm::vec3 windDirection   = DEFAULT_WIND_DIRECTION;
+    SolverMode solverMode     = SolverMode::MassSpring;
+    int       xpbdSubsteps    = DEFAULT_XPBD_SUBSTEPS;
+    float     implicitTolerance = DEFAULT_IMPLICIT_TOLERANCE;
+    int       implicitMaxIters  = DEFAULT_IMPLICIT_MAX_ITERS;
+    float     collisionThickness = DEFAULT_COLLISION_THICKNESS;
+    float     collisionFriction  = DEFAULT_COLLISION_FRICTION;
+    bool      continuousCollisions = false;
+    bool      sleepEnabled    = false;
+    float     sleepSpeed      = DEFAULT_SLEEP_SPEED;
+    int       sleepSteps      = DEFAULT_SLEEP_STEPS;
+};
+
 class Cloth
 {
 public:
@@ -40,6 +176,29 @@ public:
     /// Reset cloth to initial state (recreate particles and springs).
     void reset();
 
+    /// Change grid resolution and rebuild (like reset() at the new size).
+    /// Simulation parameters are kept; the old particle state is discarded.
+    /// Sets the display grid; the LOD level is kept and applied to it.
+    void resize(int rows, int cols, float spacing);
+
+    /// Simulate at LOD level (0 = the display grid, up to LOD_MAX_LEVEL),
+    /// carrying the current state across, see **Level of detail** above.
+    void setLodLevel(int level);
+    int  getLodLevel() const { return lodLevel; }
+
+    /// Grid the cloth is drawn at: rows/cols of the constructor or resize()
+    int getDisplayRows() const { return displayRows; }
+    int getDisplayCols() const { return displayCols; }
+
+    /// Checkpoint of the simulation state, see **Checkpoints** above.
+    std::vector<std::uint8_t> saveState() const;
+
+    /// Restore a saveState() blob; resizes the cloth to the blob's grid.
+    /// Returns false, with the cloth unchanged, if the blob is malformed or
+    /// its springs don't match the spring network of the blob's grid.
+    bool restoreState(const std::uint8_t* data, std::size_t size);
+    bool restoreState(const std::vector<std::uint8_t>& blob) { return restoreState(blob.data(), blob.size()); }
+
     /// Pin a particle at (row, col) — it will not move during simulation.
     void pin(int row, int col);
 
@@ -47,87 +206,71 @@ public:
     void unpinAll();
 
     /// Main simulation step — called once per frame.
-    /// Executes: applyForces → integrate → satisfyConstraints
+    /// Executes: applyForces → integrate → satisfyConstraints → handleColliders
+    ///
+    /// With sleepEnabled, sleeping tiles are woken first when the external
+    /// acceleration (gravity + wind) changed, or a collider whose bounds
+    /// overlap them moved, and after the step by any neighbouring tile that
+    /// is still moving. When every tile sleeps, update() returns right after
+    /// these checks.
     void update(float dt);
 
+    /// Wake every sleep tile. Called by setParams(), pin(), unpinAll() and
+    /// reset(); call it after writing parameter fields directly while the
+    /// cloth sleeps.
+    void wake();
+
+    /// Sleep tiles currently frozen, out of getTileCount().
+    int getSleepingTiles() const { return sleepState.getSleepingTiles(); }
+    int getTileCount() const { return sleepState.getTileCount(); }
+
     /// Handle collision between cloth and a sphere.
     /// Projects any particle inside the sphere to its surface (distance = radius).
     void handleSphereCollision(glm::vec3 center, float radius);
 
-    /// Handle self-collisions using marble algorithm.
-    /// Treats each particle as a sphere, prevents interpenetration.
-    void handleSelfCollisions();
-
-    // Accessors (for renderer)
-    const std::vector<Particle>& getParticles() const { return particles; }
-    const std::vector<Spring>&   getSprings()   const { return springs;   }
-    int getRows() const { return rows; }
-    int getCols() const { return cols; }
-
-    /// **Simulation Parameters** (public for real-time ImGui adjustment)
-    /// All can be tuned at runtime without rebuild.
-
-    /// Gravitational acceleration (m/s²). Typical: {0, -9.8, 0}
-    glm::vec3 gravity         = DEFAULT_GRAVITY;
-
-    /// Air resistance coefficient. Higher = more drag. Range: [0, 0.5]
-    float     airDamping      = DEFAULT_AIR_DAMPING;
-
-    /// Spring stiffness for structural and shear springs. Range: [1, 2000]
-    /// Higher = stiffer cloth, more resistance to stretching
-    float     springStiffness = DEFAULT_SPRING_STIFFNESS;
-
-    /// Bending spring stiffness. Range: [0, 500]
-    /// Controls resistance to bending/wrinkling. Typically 1/10 of springStiffness
-    float     bendStiffness   = DEFAULT_BEND_STIFFNESS;
-
-    /// Spring damping coefficient (Rayleigh damping). Range: [0, 1]
-    /// Smooths motion, reduces oscillation. Critical for stability.
-    /// Applied as: F_damp = -damping * (v_rel · spring_dir) * spring_dir
-    float     springDamping   = DEFAULT_SPRING_DAMPING;
-
-    /// Maximum stretch factor. Range: [1.0, 1.3]
-    /// If spring_dist > maxStretch * rest_length, constraint clamps it down.
-    /// Prevents unrealistic stretching
-    float     maxStretch      = DEFAULT_MAX_STRETCH;
-
-    /// Maximum compression factor. Range: [0.7, 1.0]
-    /// If spring_dist < maxCompress * rest_length, constraint expands it.
-    /// Prevents collapse
-    float     maxCompress     = DEFAULT_MAX_COMPRESS;
-
-    /// Number of constraint solver iterations per frame. Range: [1, 40]
-    /// Higher = more accurate but slower.
-    /// Each iteration processes all springs once (O(springs) per iter).
-    /// Typical: 8-15. Use lower values for real-time performance.
-    int       constraintIters = DEFAULT_CONSTRAINT_ITERS;
-
-    /// Wind force parameters
-    bool      windEnabled     = false;       ///< Enable/disable wind
-    float     windStrength    = DEFAULT_WIND_STRENGTH;  ///< Wind magnitude
-    glm::vec3 windDirection   = DEFAULT_WIND_DIRECTION; ///< Wind direction (normalized)
-    float     globalTime      = 0.f;         ///< Accumulated time for wind oscillation
+    /// Push particles out of every shape in `colliders` (see Collider.h).
+    /// Run by update() after the constraint pass (after every substep in
+    /// XPBD mode); no-op when there are no colliders.
+    ///
+    /// Pinned particles are left alone. After a contact, positional
+    /// friction removes collisionFriction of the particle's tangential
+    /// motion over the step. Particles are independent, so this runs in
+    /// parallel and is deterministic for any thread count.
+    void handleColliders();
 
-private:
-    /// Helper: compute flat index from (row, col) grid coordinates.
-    /// Particles stored as: particles[row * cols + col]
-    /// Used throughout: particle[idx(r, c)] = particle at grid(r, c)
-    int idx(int row, int col) const { return row * cols + col; }
+    /// **Continuous collision** over the step's prev → pos trajectories.
+    /// Run by update() after handleColliders() when continuousCollisions is
+    /// set; catches what the discrete passes miss at large dt or high speed.
+    ///
+    /// - Cloth vs mesh colliders: vertex–triangle, the mesh at its current
+    ///   pose. A particle whose path crosses a triangle is put back on the
+    ///   side it came from, `collisionThickness` off the surface.
+    /// - Cloth vs itself: vertex–triangle and edge–edge between the grid's
+    ///   triangles (as in ClothExport), skipping primitives that share a
+    ///   particle. Hits roll the involved particles back along their paths
+    ///   to 90% of the time of impact; repeated for ccdIterations passes,
+    ///   and particles still colliding in the last pass stay at prev.
+    ///
+    /// Broadphase: swept AABBs (prev ∪ pos, padded) in TriangleBvh, the mesh
+    /// collider trees for the first case and a refit tree over the cloth's
+    /// own triangles for the second. Only pairs whose boxes overlap reach
+    /// the cubic solve (see Ccd.h), so the narrowphase cost follows the
+    /// number of close pairs, not the cloth size. Results are gathered per
+    /// primitive and merged serially: deterministic for any thread count.
+    void handleContinuousCollisions();
 
-    /// Build initial particle grid. Called by constructor and reset().
-    /// Places particles in a regular grid, hangs from top two corners.
-    void buildParticles();
+    /// Contacts found by the last handleContinuousCollisions(), all passes.
+    int getContinuousContacts() const { return ccdContacts; }
 
-    /// Build spring network. Called by constructor and reset().
-    /// Connects particles with:
-    /// - Structural springs (immediate neighbors: up, down, left, right)
-    /// - Shear springs (diagonals: prevents face collapse)
-    /// - Bending springs (two-ring: resists wrinkling)
-    void buildSprings();
+    /// Handle self-collisions using marble algorithm.
+    /// Treats each particle as a sphere, prevents interpenetration.
+    /// Candidate pairs come from a spatial-hash broadphase rebuilt each call;
+    /// pairs already joined by a spring are skipped.
+    void handleSelfCollisions();
 
-    /// Add a spring between particles a and b.
-    /// Sets rest length to current distance, stores stiffness and type.
-    void addSpring(int a, int b, float stiffness, SpringType type);
+    // ── Pipeline phases ─────────────────────────────────────────────────────
+    // update() runs these in order. They are public so tools such as
+    // clothsim_bench can time each phase on its own.
 
     /// **Physics Step 1: Force Accumulation**
     /// Compute total force acting on each particle:
@@ -172,7 +315,7 @@ private:
     /// 3. Recover velocity (for damping): v = (x_new - x_prev) / (2*dt)
     /// 4. Advance state: x_prev = x, x = x_new
     ///
-    /// **Pinned particles:** not updated (position stays fixed)
+    /// **Pinned particles:** invMass = 0 masks the step, so position stays fixed
     void integrate(float dt);
 
     /// **Physics Step 3: Constraint Satisfaction**
@@ -203,12 +346,383 @@ private:
     /// Fixing one spring can violate neighbors. Multiple passes let
     /// corrections propagate through the network.
     /// Typical: 8-15 iterations for smooth, stable cloth.
+    ///
+    /// **Parallelism:**
+    /// Each sweep walks springBatches in order (Gauss-Seidel across colours);
+    /// the springs inside one batch are independent and run in parallel.
+    ///
+    /// **Early out:**
+    /// Every sweep records the largest relative violation it corrected.
+    /// The loop ends once that is at most constraintTolerance, so a cloth
+    /// at rest costs one sweep instead of constraintIters.
+    ///
+    /// **Multigrid:**
+    /// With multigridConstraints, the MultigridStretch pass runs first. It
+    /// is skipped while any tile sleeps, since it would move sleeping
+    /// particles.
     void satisfyConstraints();
 
-    std::vector<Particle> particles;  ///< Grid of particles (flat 1D array)
-    std::vector<Spring>   springs;    ///< All springs connecting particles
+    /// Sweeps run by the last satisfyConstraints(), and the largest
+    /// relative violation the final one found.
+    int   getConstraintIterations() const { return constraintIterations; }
+    float getConstraintViolation()  const { return constraintViolation; }
+
+    /// KernelFeature bits of the spring kernels the last phase ran, and
+    /// their names joined with '+' ("none" for 0).
+    unsigned           getKernelFeatures() const { return kernelFeatures; }
+    static std::string kernelFeatureNames(unsigned features);
+
+    /// **Implicit Integration (Baraff & Witkin, "Large Steps in Cloth Simulation")**
+    ///
+    /// One backward-Euler step, linearized around the current state:
+    /// ```
+    /// (M - h ∂f/∂v - h² ∂f/∂x) Δv = h (f₀ + h ∂f/∂x v₀)
+    /// v = v₀ + Δv,  x += h v
+    /// ```
+    /// v₀ is recovered from the Verlet state as (pos - prev) / h. Per spring,
+    /// with n = unit(p_b - p_a), l = |p_b - p_a|:
+    /// - ∂f_a/∂x_b = k (n nᵀ + max(0, 1 - L/l) (I - n nᵀ)); the compressive
+    ///   part of the transverse term is dropped so the matrix stays SPD
+    /// - ∂f_a/∂v_b = d n nᵀ, and air damping adds -airDamping · I per particle
+    ///
+    /// The 3×3 blocks go into a BlockSparseMatrix whose pattern is the spring
+    /// adjacency cached by buildSprings(). The system is solved with a
+    /// block-Jacobi PCG on the thread pool, warm-started from the previous
+    /// step's Δv, to implicitTolerance or implicitMaxIters. Pinned particles
+    /// are filtered out of the solve (Δv = 0). Writes pos/prev/vel like
+    /// integrate(), so the modes can be switched between steps.
+    void integrateImplicit(float dt);
+
+    /// PCG iterations used by the last integrateImplicit().
+    int getImplicitIterations() const { return implicitIterations; }
+
+    /// **XPBD constraint sweep** (one iteration, substep length h)
+    ///
+    /// For each spring, C = |p_b - p_a| - restLength, compliance
+    /// α = 1 / stiffness, α̃ = α / h², damping γ = α · damping / h:
+    /// ```
+    /// Δλ  = (-C - γ · n·(Δx_b - Δx_a)) / ((1 + γ)(w_a + w_b) + α̃)
+    /// p_a -= w_a Δλ n,  p_b += w_b Δλ n
+    /// ```
+    /// where n is the unit vector a → b and Δx is the motion since the
+    /// substep began. λ starts at zero every substep (one iteration per
+    /// substep), so no multiplier state is kept. Springs with zero stiffness
+    /// are skipped. Δλ is then widened if needed so the spring also ends
+    /// inside [maxCompress, maxStretch] · restLength, the same strain limit
+    /// satisfyConstraints() enforces. Uses the same colour batches.
+    void solveXPBD(float h);
+
+    // Accessors (for renderer)
+    /// AoS view of the particle state in grid order (row * cols + col),
+    /// gathered from the SoA store on first access after a change. Prefer
+    /// getParticleData() in hot paths.
+    const std::vector<Particle>& getParticles() const;
+    /// SoA store, in slot order: use particleIndex() to address grid cells.
+    const ParticleSoA&           getParticleData() const { return store; }
+    /// Store slot of grid cell (row, col).
+    int particleIndex(int row, int col) const { return gridToSlot[row * cols + col]; }
+    /// Store slot of every grid cell, indexed by row * cols + col.
+    const std::vector<int>&      getGridToSlot() const { return gridToSlot; }
+    const std::vector<Spring>&   getSprings()   const { return springs;   }
+    const std::vector<SpringBatch>& getSpringBatches() const { return springBatches; }
+    int getRows() const { return rows; }
+    int getCols() const { return cols; }
+    float getSpacing() const { return spacing; }
+
+    /// Snapshot / bulk-assign the simulation parameters below.
+    /// Like direct field writes, every field takes effect on the next step.
+    ClothParams getParams() const;
+    void        setParams(const ClothParams& params);
+
+    /// Thread pool used by the parallel solver phases.
+    /// nullptr (the default) means ThreadPool::shared().
+    void setThreadPool(ThreadPool* pool) { threadPool = pool; }
+
+    /// **Simulation Parameters** (public for real-time ImGui adjustment)
+    /// All can be tuned at runtime without rebuild.
+
+    /// Gravitational acceleration (m/s²). Typical: {0, -9.8, 0}
+    glm::vec3 gravity         = DEFAULT_GRAVITY;
+
+    /// Air resistance coefficient. Higher = more drag. Range: [0, 0.5]
+    float     airDamping      = DEFAULT_AIR_DAMPING;
+
+    /// Spring stiffness for structural and shear springs. Range: [1, 2000]
+    /// Higher = stiffer cloth, more resistance to stretching
+    float     springStiffness = DEFAULT_SPRING_STIFFNESS;
+
+    /// Bending spring stiffness. Range: [0, 500]
+    /// Controls resistance to bending/wrinkling. Typically 1/10 of springStiffness
+    float     bendStiffness   = DEFAULT_BEND_STIFFNESS;
+
+    /// Spring damping coefficient (Rayleigh damping). Range: [0, 1]
+    /// Smooths motion, reduces oscillation. Critical for stability.
+    /// Applied as: F_damp = -damping * (v_rel · spring_dir) * spring_dir
+    float     springDamping   = DEFAULT_SPRING_DAMPING;
+
+    /// Maximum stretch factor. Range: [1.0, 1.3]
+    /// If spring_dist > maxStretch * rest_length, constraint clamps it down.
+    /// Prevents unrealistic stretching
+    float     maxStretch      = DEFAULT_MAX_STRETCH;
+
+    /// Maximum compression factor. Range: [0.7, 1.0]
+    /// If spring_dist < maxCompress * rest_length, constraint expands it.
+    /// Prevents collapse
+    float     maxCompress     = DEFAULT_MAX_COMPRESS;
+
+    /// Store order, see ParticleLayout. Applied by the constructor and reset().
+    ParticleLayout particleLayout = ParticleLayout::Tiled;
+
+    /// Offset of the initial grid from its default placement (centered on
+    /// x = 0, top row at y = (rows - 1) * spacing, z = 0). Applied by reset().
+    glm::vec3 origin          = glm::vec3(0.f);
+
+    /// Integration scheme, see SolverMode. MassSpring is the reference.
+    SolverMode solverMode     = SolverMode::MassSpring;
+
+    /// XPBD substeps per update(); each runs one constraint sweep. Range: [1, 40]
+    /// Cost is roughly that of constraintIters = xpbdSubsteps plus one
+    /// external-force and Verlet pass per substep.
+    int       xpbdSubsteps    = DEFAULT_XPBD_SUBSTEPS;
+
+    /// Implicit mode: PCG stops at |r| <= implicitTolerance * |b| ...
+    float     implicitTolerance = DEFAULT_IMPLICIT_TOLERANCE;
+    /// ... or after this many iterations.
+    int       implicitMaxIters  = DEFAULT_IMPLICIT_MAX_ITERS;
+
+    /// Shapes the cloth collides with, see handleColliders().
+    ColliderSet colliders;
+
+    /// Distance particles are kept from collider surfaces (m). Range: [0, 0.05]
+    float     collisionThickness = DEFAULT_COLLISION_THICKNESS;
+
+    /// Fraction of tangential motion removed on contact. Range: [0, 1]
+    /// 0 = frictionless sliding, 1 = cloth sticks where it lands.
+    float     collisionFriction  = DEFAULT_COLLISION_FRICTION;
+
+    /// Run handleContinuousCollisions() every step (and XPBD substep).
+    bool      continuousCollisions = false;
+    /// Detect-and-roll-back passes of the self CCD. Range: [1, 16]
+    int       ccdIterations      = DEFAULT_CCD_ITERATIONS;
+
+    /// Freeze settled tiles, see **Sleeping** above.
+    bool      sleepEnabled       = false;
+    /// A particle is at rest below this mean speed (m/s), measured as its
+    /// drift over the last sleepSteps update() calls (whole frames, in XPBD
+    /// mode too), so jitter in place does not count. A corner-pinned drape whose sweeps
+    /// stop at the iteration cap still creeps at a few cm/s; 0.05 freezes
+    /// it, the default only cloth resting on a collider. Range: [0, 0.1]
+    float     sleepSpeed         = DEFAULT_SLEEP_SPEED;
+    /// Consecutive update() calls at rest before a tile falls asleep. Range: [1, 240]
+    int       sleepSteps         = DEFAULT_SLEEP_STEPS;
+
+    /// Number of constraint solver iterations per frame. Range: [1, 40]
+    /// Higher = more accurate but slower.
+    /// Each iteration processes all springs once (O(springs) per iter).
+    /// Typical: 8-15. Use lower values for real-time performance.
+    /// Upper bound only: sweeps stop early at constraintTolerance.
+    int       constraintIters = DEFAULT_CONSTRAINT_ITERS;
+
+    /// satisfyConstraints() stops after a sweep whose largest violation,
+    /// |dist - clamp(dist, minLen, maxLen)| / restLength, is at most this.
+    /// Range: [0, 0.05]. 0 = always run constraintIters (a sweep that
+    /// finds nothing out of range still ends the loop, since later ones
+    /// could not change anything).
+    float     constraintTolerance = DEFAULT_CONSTRAINT_TOLERANCE;
+
+    /// Run the MultigridStretch pass before the sweeps, so stretch is limited
+    /// across the whole cloth in a few sweeps at any resolution.
+    /// Mass-spring and implicit modes.
+    bool      multigridConstraints = false;
+
+    /// Project each colour batch of springs in parallel across the thread pool.
+    /// Batches are processed in a fixed order and springs within a batch share
+    /// no particle, so results are identical for any thread count.
+    bool      parallelConstraints = true;
+
+    /// Spring-force accumulation path. Serial is the reference; ParallelGather
+    /// gives the same forces up to float summation order.
+    ForceMode forceMode = ForceMode::ParallelGather;
+
+    /// Run the spring kernels instantiated for the features in use. false
+    /// runs the one with damping and weighted corrections compiled in,
+    /// whatever the parameters: the same results, as a benchmark baseline.
+    bool      specializedKernels = true;
+
+    /// Wind force parameters
+    bool      windEnabled     = false;       ///< Enable/disable wind
+    float     windStrength    = DEFAULT_WIND_STRENGTH;  ///< Wind magnitude
+    glm::vec3 windDirection   = DEFAULT_WIND_DIRECTION; ///< Wind direction (normalized)
+    float     globalTime      = 0.f;         ///< Accumulated time for wind oscillation
+
+private:
+    /// Helper: store slot of (row, col) grid coordinates.
+    /// Particles stored as: store.posX[gridToSlot[row * cols + col]] (and every other array)
+    /// Used throughout: particle[idx(r, c)] = particle at grid(r, c)
+    int idx(int row, int col) const { return gridToSlot[row * cols + col]; }
+
+    /// Side of a ParticleLayout::Tiled tile, in particles
+    static constexpr int LAYOUT_TILE = 8;
+
+    /// Fill gridToSlot for particleLayout. Called by buildParticles().
+    void buildLayout();
+
+    /// Build initial particle grid. Called by constructor and reset().
+    /// Places particles in a regular grid, hangs from top two corners.
+    void buildParticles();
+
+    /// Build spring network. Called by constructor and reset().
+    /// Connects particles with:
+    /// - Structural springs (immediate neighbors: up, down, left, right)
+    /// - Shear springs (diagonals: prevents face collapse)
+    /// - Bending springs (two-ring: resists wrinkling)
+    void buildSprings();
+
+    /// Add a spring between particles a and b.
+    /// Sets rest length to current distance and stores the type.
+    void addSpring(int a, int b, SpringType type);
+
+    /// Greedy graph colouring of springs, per SpringType.
+    /// Reorders springs by (type, colour, a, b) and fills springBatches.
+    void colorSprings();
+
+    /// Mirror springs into solverSprings and record where each type ends.
+    void buildSolverSprings();
+
+    /// Refresh the per-type stiffness table from the public fields, and the
+    /// cached constraint bounds if maxStretch/maxCompress changed since the
+    /// last call, and pick the kernel instantiations (kernelFeatures).
+    /// Called at the start of every spring phase.
+    void syncSpringParams();
+
+    /// Arrays and constants of the current state, for the spring kernels.
+    SpringKernelArgs springKernelArgs();
+
+    /// Type of spring k, from its position in the (type-sorted) spring order.
+    SpringType springTypeAt(int k) const
+    {
+        return k < springTypeEnd[0] ? SpringType::Structural
+             : k < springTypeEnd[1] ? SpringType::Shear : SpringType::Bending;
+    }
+
+    /// Current stiffness of springs of the given type.
+    float stiffnessOf(SpringType type) const { return springTypeStiffness[(int)type]; }
+
+    /// Build per-particle spring adjacency (CSR). Called at the end of buildSprings().
+    /// Neighbors of particle i: adjacency[adjacencyStart[i] .. adjacencyStart[i + 1]),
+    /// with the matching incident springs in incidentSprings over the same range.
+    void buildAdjacency();
+
+    /// Wake tiles for changes since the last step (acceleration, colliders),
+    /// start the quiet runs of tiles that need one, and refresh the awake
+    /// lists. Returns false when every tile sleeps.
+    bool beginSleepStep();
+
+    /// After a step of length h: let sleepState count quiet steps and put
+    /// settled tiles to sleep (see SleepTracker::update()).
+    void updateSleep(float h);
+
+    /// Rebuild sleepState's awake lists if a tile changed state.
+    void refreshSleep();
+
+    /// Inverse masses for the constraint passes: 0 for pinned and sleeping.
+    const float* solverInvMass() const
+    {
+        return sleepState.getSleepingTiles() > 0 ? sleepState.getInvMass().data() : store.invMass.data();
+    }
+
+    /// Grid triangles and their edges (in store slots) for the self CCD.
+    /// Called at the end of buildSprings().
+    void buildCollisionMesh();
+
+    /// True if particles a and b are joined by any spring.
+    /// Scans a's adjacency row (at most 12 entries on a regular grid).
+    bool connected(int a, int b) const;
+
+    /// Gravity + (oscillating) wind as one per-unit-mass acceleration.
+    glm::vec3 externalAcceleration() const;
+
+    /// Verlet stores velocity implicitly as (pos - prev) over the last step.
+    /// If the step length changes (dt slider, solver mode switch), rescale
+    /// prev so the implied velocity is preserved.
+    void matchStepLength(float h);
+
+    /// ForceMode::Serial — scatter into both endpoints on one thread.
+    void accumulateSpringForcesSerial();
+
+    /// ForceMode::ParallelGather — per-spring forces, then per-particle gather.
+    void accumulateSpringForcesGather();
+
+    /// Pool for parallel phases (falls back to ThreadPool::shared()).
+    ThreadPool& pool() const { return threadPool ? *threadPool : ThreadPool::shared(); }
+
+    ParticleSoA           store;      ///< Particle state, one aligned array per component
+    std::vector<int>      gridToSlot; ///< Store slot of grid cell row * cols + col
+    std::vector<Spring>   springs;    ///< All springs connecting particles, sorted by (type, colour)
+    std::vector<SpringBatch> springBatches; ///< Independent colour batches over springs
+    std::vector<SolverSpring> solverSprings; ///< Hot-loop copy of springs, same order
+
+    float springTypeStiffness[3] = {};   ///< Stiffness per SpringType, see syncSpringParams()
+    int   springTypeEnd[3]       = {};   ///< One past the last spring of each SpringType
+    unsigned kernelFeatures      = KernelAll; ///< KernelFeature bits, see syncSpringParams()
+    bool  invMassDirty   = true;         ///< Pins changed: rescan for invMassUniform
+    bool  invMassUniform = false;        ///< Every store.invMass equals uniformInvMass > 0
+    float uniformInvMass = 0.f;
+    float boundsStretch  = 0.f;          ///< maxStretch the cached bounds were built with
+    float boundsCompress = 0.f;          ///< maxCompress the cached bounds were built with
+    ThreadPool*           threadPool = nullptr; ///< Non-owning; nullptr = shared pool
+
+    mutable std::vector<Particle> particleView;     ///< AoS cache returned by getParticles()
+    mutable bool                  particleViewDirty = true;
+
+    std::vector<int>      adjacencyStart; ///< CSR row offsets into adjacency (size = particles + 1)
+    std::vector<int>      adjacency;      ///< Spring-connected neighbor indices, grouped per particle
+    std::vector<int>      incidentSprings;///< Incident spring per adjacency entry: k (as a) or ~k (as b)
+    std::vector<glm::vec3> springForces;  ///< Per-spring force scratch for the gather path
+    std::vector<glm::vec3> collisionPositions; ///< Broadphase input, reused across steps
+    SpatialHash           selfCollisionHash;  ///< Self-collision broadphase, rebuilt every call
+
+    float lastStep = 0.f;  ///< Length of the last Verlet step (0 = none since reset)
+
+    SleepTracker sleepState;   ///< Sleep tiles and awake lists, see **Sleeping** above
+
+    /// Refit steps before the self-CCD tree is rebuilt from scratch
+    static constexpr int CCD_REBUILD_INTERVAL = 32;
+
+    std::vector<glm::ivec3> clothTriangles;   ///< Grid triangles, store slots
+    std::vector<glm::ivec2> clothEdges;       ///< Unique edges of clothTriangles
+    std::vector<glm::ivec3> clothTriangleEdges; ///< Edge ids of each triangle
+    TriangleBvh            ccdBvh;            ///< Swept-bounds tree over clothTriangles
+    int                    ccdBvhAge = 0;     ///< handleContinuousCollisions() calls since build
+    std::vector<glm::vec3> ccdPrevious;       ///< prev positions, AoS for the BVH
+    std::vector<float>     ccdVertexToi;      ///< Earliest vertex–triangle hit per vertex
+    std::vector<int>       ccdVertexTriangle; ///< ... and the triangle it hit
+    std::vector<float>     ccdEdgeToi;        ///< Earliest edge–edge hit per edge
+    std::vector<int>       ccdEdgeOther;      ///< ... and the other edge
+    std::vector<float>     ccdRollback;       ///< Earliest impact per particle, this pass
+    std::vector<glm::vec3> ccdBoxLo, ccdBoxHi; ///< Padded swept box per particle, this pass
+    int                    ccdContacts = 0;
+
+    BlockSparseMatrix      implicitMatrix;    ///< System matrix; pattern = spring adjacency
+    PcgSolver              implicitSolver;
+    std::vector<glm::vec3> implicitVelocity;  ///< v₀ for the current step
+    std::vector<glm::vec3> implicitRhs;
+    std::vector<glm::vec3> implicitDv;        ///< Solution, kept as the next warm start
+    std::vector<float>     implicitMask;      ///< 0 for pinned particles
+    std::vector<glm::mat3> springJacobians;   ///< h·d·nnᵀ + h²·∂f_a/∂x_b per spring
+    std::vector<glm::vec3> springImplicitForces; ///< f + h·∂f_a/∂x_b·(v_b - v_a) per spring
+    int                    implicitIterations = 0;
+
+    MultigridStretch       multigrid;         ///< Coarse stretch pass (multigridConstraints)
+
+    int   constraintIterations = 0;   ///< Sweeps of the last satisfyConstraints()
+    float constraintViolation  = 0.f; ///< Largest violation of its last sweep
 
     int   rows, cols;  ///< Grid dimensions
     float spacing;     ///< Distance between adjacent particles
+
+    int   displayRows, displayCols;   ///< Level-0 grid (constructor / resize())
+    float displaySpacing;
+    int   lodLevel = 0;
 };
 
@@ -0,0 +1,481 @@
+#include "ClothCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define CLOTH_CACHE_MMAP 1
+#endif
+
+namespace
+{
+    constexpr float QUANT_MAX = 65535.f;
+
+    size_t padTo8(size_t n) { return (n + 7) & ~size_t(7); }
+
+    uint32_t zigzag(int32_t v)   { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+    int32_t  unzigzag(uint32_t u) { return (int32_t)(u >> 1) ^ -(int32_t)(u & 1); }
+
+    void putVarint(std::vector<uint8_t>& out, uint32_t v)
+    {
+        while (v >= 0x80) {
+            out.push_back((uint8_t)(v | 0x80));
+            v >>= 7;
+        }
+        out.push_back((uint8_t)v);
+    }
+
+    bool getVarint(const uint8_t*& p, const uint8_t* end, uint32_t& v)
+    {
+        v = 0;
+        for (int shift = 0; shift < 35 && p < end; shift += 7) {
+            const uint8_t b = *p++;
+            v |= (uint32_t)(b & 0x7f) << shift;
+            if (!(b & 0x80)) return true;
+        }
+        return false;
+    }
+
+    /// Row predictor shared by the encoder and decoder, per component: linear
+    /// extrapolation from the two previous particles of the row, the previous
+    /// one at column 1, the row above's first particle at column 0.
+    struct DeltaPredictor
+    {
+        int32_t prev1[3] = {}, prev2[3] = {}, rowStart[3] = {};
+
+        int32_t predict(int col, int axis) const
+        {
+            if (col >= 2) return 2 * prev1[axis] - prev2[axis];
+            if (col == 1) return prev1[axis];
+            return rowStart[axis];
+        }
+
+        void push(int col, const int32_t q[3])
+        {
+            for (int a = 0; a < 3; ++a) {
+                if (col == 0) rowStart[a] = q[a];
+                prev2[a] = prev1[a];
+                prev1[a] = q[a];
+            }
+        }
+    };
+
+    /// Uniform per-axis quantiser over a frame's AABB
+    struct Quantizer
+    {
+        float lo[3], step[3], inv[3];
+
+        explicit Quantizer(const CacheFrameHeader& h)
+        {
+            for (int a = 0; a < 3; ++a) {
+                const float extent = h.hi[a] - h.lo[a];
+                lo[a]   = h.lo[a];
+                step[a] = extent / QUANT_MAX;
+                inv[a]  = extent > 0.f ? QUANT_MAX / extent : 0.f;
+            }
+        }
+
+        int32_t quantize(float x, int a) const
+        {
+            return (int32_t)std::clamp(std::lround((x - lo[a]) * inv[a]), 0l, (long)QUANT_MAX);
+        }
+        float dequantize(int32_t q, int a) const { return lo[a] + (float)q * step[a]; }
+    };
+}
+
+// MARK: - Writer
+ClothCacheWriter::~ClothCacheWriter()
+{
+    close();
+}
+
+bool ClothCacheWriter::open(const std::string& path, const Cloth& cloth, const ClothCacheOptions& options)
+{
+    close();
+
+    file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        std::cerr << "✗ Could not open " << path << " for writing\n";
+        return false;
+    }
+    std::setvbuf(file, nullptr, _IOFBF, 1 << 20);
+
+    rows  = cloth.getRows();
+    cols  = cloth.getCols();
+    flags = 0;
+    if (options.quantize || options.delta) flags |= CacheQuantized;
+    if (options.delta)                     flags |= CacheDelta;
+    queueFrames  = std::max(1, options.queueFrames);
+    framesQueued = 0;
+    frameOffsets.clear();
+    offset   = 0;
+    failed   = false;
+    stopping = false;
+
+    // Same triangulation as writeClothObj() and ClothRenderer, 0-based
+    std::vector<uint32_t> indices;
+    indices.reserve((size_t)(rows - 1) * (cols - 1) * 6);
+    for (int r = 0; r < rows - 1; ++r) {
+        for (int c = 0; c < cols - 1; ++c) {
+            const uint32_t i = (uint32_t)(r * cols + c);
+            const uint32_t down = i + (uint32_t)cols;
+            indices.insert(indices.end(), { i, down, i + 1, down, down + 1, i + 1 });
+        }
+    }
+    std::vector<int32_t> pins;
+    const ParticleSoA& s = cloth.getParticleData();
+    const std::vector<int>& gridToSlot = cloth.getGridToSlot();
+    for (int g = 0; g < (int)gridToSlot.size(); ++g)
+        if (s.pinned(gridToSlot[g])) pins.push_back(g);
+
+    CacheHeader header = {};
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+    header.version     = CACHE_VERSION;
+    header.flags       = flags;
+    header.rows        = rows;
+    header.cols        = cols;
+    header.indexCount  = (uint32_t)indices.size();
+    header.pinnedCount = (uint32_t)pins.size();
+    writeBytes(&header, sizeof(header));
+    writeBytes(indices.data(), indices.size() * sizeof(uint32_t));
+    writeBytes(pins.data(), pins.size() * sizeof(int32_t));
+    const uint64_t zeros = 0;
+    writeBytes(&zeros, padTo8(offset) - offset);
+
+    io = std::thread(&ClothCacheWriter::ioLoop, this);
+    return !failed;
+}
+
+void ClothCacheWriter::write(const Cloth& cloth)
+{
+    if (!file || cloth.getRows() != rows || cloth.getCols() != cols) return;
+
+    std::vector<float> xyz;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this] { return (int)queue.size() < queueFrames; });
+        if (!freeBuffers.empty()) {
+            xyz = std::move(freeBuffers.back());
+            freeBuffers.pop_back();
+        }
+    }
+
+    // Gather from store slots to grid order, like ClothSnapshot::capture()
+    const ParticleSoA& s = cloth.getParticleData();
+    const std::vector<int>& gridToSlot = cloth.getGridToSlot();
+    xyz.resize(gridToSlot.size() * 3);
+    for (size_t g = 0; g < gridToSlot.size(); ++g) {
+        const int i = gridToSlot[g];
+        xyz[g * 3 + 0] = s.posX[i];
+        xyz[g * 3 + 1] = s.posY[i];
+        xyz[g * 3 + 2] = s.posZ[i];
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back({ cloth.globalTime, std::move(xyz) });
+    }
+    changed.notify_all();
+    ++framesQueued;
+}
+
+bool ClothCacheWriter::close()
+{
+    if (!file) return true;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    io.join();
+
+    // Table, then the header fields that were unknown at open()
+    const uint64_t tableOffset = offset;
+    writeBytes(frameOffsets.data(), frameOffsets.size() * sizeof(uint64_t));
+    const uint32_t frameCount = (uint32_t)frameOffsets.size();
+    if (std::fseek(file, offsetof(CacheHeader, frameCount), SEEK_SET) != 0 ||
+        std::fwrite(&frameCount, sizeof(frameCount), 1, file) != 1 ||
+        std::fseek(file, offsetof(CacheHeader, tableOffset), SEEK_SET) != 0 ||
+        std::fwrite(&tableOffset, sizeof(tableOffset), 1, file) != 1)
+        failed = true;
+
+    bool ok = std::fclose(file) == 0 && !failed;
+    file = nullptr;
+    queue.clear();
+    freeBuffers.clear();
+    if (!ok)
+        std::cerr << "✗ Failed while writing cloth cache\n";
+    return ok;
+}
+
+void ClothCacheWriter::ioLoop()
+{
+    for (;;)
+    {
+        PendingFrame frame;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (queue.empty()) return;   // stopping and drained
+            frame = std::move(queue.front());
+            queue.pop_front();
+        }
+        changed.notify_all();   // write() may be waiting for room
+
+        encode(frame);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        freeBuffers.push_back(std::move(frame.xyz));
+    }
+}
+
+void ClothCacheWriter::encode(const PendingFrame& frame)
+{
+    const int n = rows * cols;
+    const float* xyz = frame.xyz.data();
+
+    CacheFrameHeader h = {};
+    h.time = frame.time;
+    for (int a = 0; a < 3; ++a) {
+        h.lo[a] = n > 0 ? xyz[a] : 0.f;
+        h.hi[a] = h.lo[a];
+    }
+    for (int i = 0; i < n; ++i) {
+        for (int a = 0; a < 3; ++a) {
+            h.lo[a] = std::min(h.lo[a], xyz[i * 3 + a]);
+            h.hi[a] = std::max(h.hi[a], xyz[i * 3 + a]);
+        }
+    }
+
+    encoded.clear();
+    if (!(flags & CacheQuantized)) {
+        encoded.resize((size_t)n * 3 * sizeof(float));
+        std::memcpy(encoded.data(), xyz, encoded.size());
+    } else {
+        const Quantizer quant(h);
+        DeltaPredictor pred;
+        encoded.reserve((size_t)n * 3 * sizeof(uint16_t));
+        for (int i = 0; i < n; ++i) {
+            const int col = i % cols;
+            int32_t q[3];
+            for (int a = 0; a < 3; ++a) {
+                q[a] = quant.quantize(xyz[i * 3 + a], a);
+                if (flags & CacheDelta) {
+                    putVarint(encoded, zigzag(q[a] - pred.predict(col, a)));
+                } else {
+                    encoded.push_back((uint8_t)(q[a] & 0xff));
+                    encoded.push_back((uint8_t)(q[a] >> 8));
+                }
+            }
+            pred.push(col, q);
+        }
+    }
+    const size_t payload = padTo8(encoded.size());
+    encoded.resize(payload, 0);
+    h.payloadBytes = (uint32_t)payload;
+
+    frameOffsets.push_back(offset);
+    writeBytes(&h, sizeof(h));
+    writeBytes(encoded.data(), encoded.size());
+}
+
+void ClothCacheWriter::writeBytes(const void* bytes, size_t count)
+{
+    if (count == 0 || failed) return;
+    if (std::fwrite(bytes, 1, count, file) != count)
+        failed = true;
+    offset += count;
+}
+
+// MARK: - Reader
+bool ClothCacheReader::open(const std::string& path)
+{
+    close();
+
+#if CLOTH_CACHE_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        if (fd >= 0) ::close(fd);
+        std::cerr << "✗ Could not open " << path << "\n";
+        return false;
+    }
+    size = (size_t)st.st_size;
+    void* p = size > 0 ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    ::close(fd);   // the mapping keeps the file alive
+    if (p == MAP_FAILED) {
+        std::cerr << "✗ Could not map " << path << "\n";
+        size = 0;
+        return false;
+    }
+    data   = static_cast<const uint8_t*>(p);
+    mapped = true;
+#else
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) {
+        std::cerr << "✗ Could not open " << path << "\n";
+        return false;
+    }
+    std::fseek(f, 0, SEEK_END);
+    size = (size_t)std::ftell(f);
+    std::fseek(f, 0, SEEK_SET);
+    uint8_t* copy = new uint8_t[size];
+    const bool read = std::fread(copy, 1, size, f) == size;
+    std::fclose(f);
+    data = copy;
+    if (!read) {
+        close();
+        std::cerr << "✗ Could not read " << path << "\n";
+        return false;
+    }
+#endif
+
+    auto fail = [&](const char* why) {
+        close();
+        std::cerr << "✗ " << path << ": " << why << "\n";
+        return false;
+    };
+
+    if (size < sizeof(CacheHeader))
+        return fail("too small for a cloth cache");
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0)
+        return fail("not a cloth cache");
+    if (header.version != CACHE_VERSION)
+        return fail("unsupported cache version");
+    // 64-bit products: a crafted header must not overflow the int counts
+    // (particle * 3 float indices) or the index buffer the renderer trusts
+    if (header.rows < 2 || header.cols < 2 ||
+        (int64_t)header.rows * header.cols * 3 > INT32_MAX)
+        return fail("bad grid size");
+    if ((uint64_t)header.indexCount != (uint64_t)(header.rows - 1) * (header.cols - 1) * 6)
+        return fail("index count does not match the grid");
+    if (header.pinnedCount > (uint64_t)header.rows * header.cols)
+        return fail("bad pinned particle list");
+
+    const size_t indexBytes  = (size_t)header.indexCount * sizeof(uint32_t);
+    const size_t pinnedBytes = (size_t)header.pinnedCount * sizeof(int32_t);
+    const size_t framesStart = padTo8(sizeof(CacheHeader) + indexBytes + pinnedBytes);
+    if (framesStart > size)
+        return fail("truncated header");
+    indices = reinterpret_cast<const uint32_t*>(data + sizeof(CacheHeader));
+    pinned  = reinterpret_cast<const int32_t*>(data + sizeof(CacheHeader) + indexBytes);
+    for (int k = 0; k < getPinnedCount(); ++k)
+        if (pinned[k] < 0 || pinned[k] >= getParticleCount() || (k > 0 && pinned[k] <= pinned[k - 1]))
+            return fail("bad pinned particle list");
+    for (int k = 0; k < getIndexCount(); ++k)
+        if (indices[k] >= (uint32_t)getParticleCount())
+            return fail("triangle index out of range");
+
+    frames.clear();
+    if (header.tableOffset != 0) {
+        if (header.tableOffset > size ||
+            (uint64_t)header.frameCount * sizeof(uint64_t) > size - header.tableOffset)
+            return fail("truncated frame table");
+        frames.resize(header.frameCount);
+        std::memcpy(frames.data(), data + header.tableOffset, frames.size() * sizeof(uint64_t));
+        for (int k = 0; k < (int)frames.size(); ++k)
+            if (frames[k] > size - sizeof(CacheFrameHeader) ||
+                frames[k] + getFrameBytes(k) > size)
+                return fail("frame table points past the end");
+    } else {
+        // Not closed: recover every complete frame
+        uint64_t off = framesStart;
+        while (off + sizeof(CacheFrameHeader) <= size) {
+            const auto* h = reinterpret_cast<const CacheFrameHeader*>(data + off);
+            const uint64_t end = off + sizeof(CacheFrameHeader) + h->payloadBytes;
+            if (end > size) break;
+            frames.push_back(off);
+            off = end;
+        }
+        std::cerr << "✗ " << path << " was not closed; recovered " << frames.size() << " frames\n";
+    }
+
+    std::cout << "✓ Cloth cache " << path << ": " << header.rows << "x" << header.cols << ", "
+              << frames.size() << " frames\n";
+    return true;
+}
+
+void ClothCacheReader::close()
+{
+    if (data) {
+#if CLOTH_CACHE_MMAP
+        if (mapped) munmap(const_cast<uint8_t*>(data), size);
+#endif
+        if (!mapped) delete[] data;
+    }
+    data    = nullptr;
+    size    = 0;
+    mapped  = false;
+    header  = {};
+    indices = nullptr;
+    pinned  = nullptr;
+    frames.clear();
+}
+
+bool ClothCacheReader::readFrame(int frame, float* xyz, float* pinnedXyz) const
+{
+    if (!data || frame < 0 || frame >= getFrameCount()) return false;
+
+    const CacheFrameHeader& h = frameHeader(frame);
+    const uint8_t* p   = reinterpret_cast<const uint8_t*>(&h + 1);
+    const uint8_t* end = p + h.payloadBytes;
+    const int n    = getParticleCount();
+    const int cols = header.cols;
+
+    // Pinned particles are sorted, so one cursor collects them on the way
+    int nextPin = 0;
+    auto collectPin = [&](int i, const float v[3]) {
+        if (!pinnedXyz) return;
+        while (nextPin < getPinnedCount() && pinned[nextPin] == i) {
+            std::memcpy(pinnedXyz + nextPin * 3, v, 3 * sizeof(float));
+            ++nextPin;
+        }
+    };
+
+    if (!(header.flags & CacheQuantized)) {
+        if ((size_t)n * 3 * sizeof(float) > h.payloadBytes) return false;
+        const float* src = reinterpret_cast<const float*>(p);
+        std::memcpy(xyz, src, (size_t)n * 3 * sizeof(float));
+        if (pinnedXyz)
+            for (int k = 0; k < getPinnedCount(); ++k)
+                std::memcpy(pinnedXyz + k * 3, src + (size_t)pinned[k] * 3, 3 * sizeof(float));
+        return true;
+    }
+
+    const Quantizer quant(h);
+    DeltaPredictor pred;
+    const bool delta = (header.flags & CacheDelta) != 0;
+    if (!delta && (size_t)n * 3 * sizeof(uint16_t) > h.payloadBytes) return false;
+
+    for (int i = 0; i < n; ++i) {
+        const int col = i % cols;
+        int32_t q[3];
+        float   v[3];
+        for (int a = 0; a < 3; ++a) {
+            if (delta) {
+                uint32_t u;
+                if (!getVarint(p, end, u)) return false;
+                q[a] = pred.predict(col, a) + unzigzag(u);
+            } else {
+                q[a] = (int32_t)p[0] | ((int32_t)p[1] << 8);
+                p += 2;
+            }
+            v[a] = quant.dequantize(q[a], a);
+        }
+        pred.push(col, q);
+        xyz[i * 3 + 0] = v[0];
+        xyz[i * 3 + 1] = v[1];
+        xyz[i * 3 + 2] = v[2];
+        collectPin(i, v);
+    }
+    return true;
+}
@@ -0,0 +1,197 @@
+#pragma once
+
+#include "Cloth.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// @file ClothCache.h
+/// Streaming binary cache of a simulated cloth sequence: written while the
+/// simulation runs, played back later frame by frame without re-parsing.
+///
+/// **Layout (little-endian):**
+/// - CacheHeader: magic, rows/cols, flags, counts and the offset of the
+///   frame table (written by close())
+/// - Index buffer: uint32 triangle indices, the grid triangulation of
+///   writeClothObj() / ClothRenderer (0-based, grid order)
+/// - Pinned particles: int32 grid indices, sorted
+/// - Frames, back to back: CacheFrameHeader (time, payload size, AABB)
+///   followed by the positions of every particle in grid order
+/// - Frame table: uint64 file offset of each CacheFrameHeader
+///
+/// A file whose writer died before close() has no table; the reader then
+/// walks the frames from the start instead.
+///
+/// **Frame encodings (CacheHeader::flags):**
+/// - Raw:       float x, y, z per particle (12 bytes)
+/// - Quantized: uint16 x, y, z relative to the frame's AABB (6 bytes),
+///   error at most half of extent / 65535 per axis
+/// - Delta:     the quantised values, each predicted from the particles
+///   before it in its row (linear extrapolation; the first column from the
+///   row above) and stored as zigzag varint residuals. Lossless on top of
+///   quantisation, typically 1-2 bytes per component on a smooth cloth.
+///   Implies Quantized.
+///
+/// Every frame is self-contained: there is no inter-frame prediction, so
+/// scrubbing to any frame decodes exactly one block.
+///
+/// **Threading:**
+/// ClothCacheWriter::write() only copies the positions; encoding and file
+/// I/O run on the writer's own thread, up to queueFrames frames behind.
+/// ClothCacheReader maps the file and decodes on the calling thread.
+
+/// Bits of CacheHeader::flags
+enum CacheFlags : uint32_t
+{
+    CacheQuantized = 1u << 0,
+    CacheDelta     = 1u << 1
+};
+
+struct CacheHeader
+{
+    char     magic[8];          ///< CACHE_MAGIC
+    uint32_t version;           ///< CACHE_VERSION
+    uint32_t flags;             ///< CacheFlags
+    int32_t  rows, cols;
+    uint32_t indexCount;
+    uint32_t pinnedCount;
+    uint32_t frameCount;        ///< 0 until close()
+    uint32_t reserved;
+    uint64_t tableOffset;       ///< 0 until close()
+    uint8_t  pad[16];
+};
+static_assert(sizeof(CacheHeader) == 64, "CacheHeader is part of the file format");
+
+struct CacheFrameHeader
+{
+    float    time;              ///< Cloth::globalTime when written
+    uint32_t payloadBytes;      ///< Bytes after this header, padded to 8
+    float    lo[3], hi[3];      ///< AABB of the frame (quantised encodings)
+};
+static_assert(sizeof(CacheFrameHeader) == 32, "CacheFrameHeader is part of the file format");
+
+constexpr char     CACHE_MAGIC[8] = { 'C', 'L', 'T', 'H', 'C', 'A', 'C', 'H' };
+constexpr uint32_t CACHE_VERSION  = 1;
+
+struct ClothCacheOptions
+{
+    bool quantize    = false;   ///< CacheQuantized
+    bool delta       = false;   ///< CacheDelta (implies quantize)
+    int  queueFrames = 8;       ///< Frames write() may run ahead of the disk before it blocks
+};
+
+// MARK: - Writer
+class ClothCacheWriter
+{
+public:
+    ClothCacheWriter() = default;
+    ~ClothCacheWriter();   ///< Calls close()
+
+    ClothCacheWriter(const ClothCacheWriter&)            = delete;
+    ClothCacheWriter& operator=(const ClothCacheWriter&) = delete;
+
+    /// Create path for frames of cloth's size and write the header, index
+    /// buffer and pins. Starts the I/O thread.
+    /// @return false (and prints to std::cerr) if the file cannot be created
+    bool open(const std::string& path, const Cloth& cloth, const ClothCacheOptions& options = {});
+
+    /// Queue cloth's current positions as the next frame. Blocks only while
+    /// queueFrames frames are still waiting for the disk. The cloth must
+    /// have the rows/cols given to open().
+    void write(const Cloth& cloth);
+
+    /// Drain the queue, write the frame table and finish the header.
+    /// @return false if any write failed since open()
+    bool close();
+
+    bool isOpen()        const { return file != nullptr; }
+    int  getFrameCount() const { return framesQueued; }   ///< Frames passed to write()
+
+private:
+    struct PendingFrame
+    {
+        float              time;
+        std::vector<float> xyz;    ///< Grid order
+    };
+
+    void ioLoop();
+    void encode(const PendingFrame& frame);
+    void writeBytes(const void* data, size_t bytes);
+
+    std::FILE* file = nullptr;
+    uint32_t   flags = 0;
+    int        rows = 0, cols = 0;
+    int        queueFrames  = 8;
+    int        framesQueued = 0;
+
+    std::thread                     io;
+    std::mutex                      mutex;
+    std::condition_variable         changed;      ///< Queue or stop state changed
+    std::deque<PendingFrame>        queue;        ///< Guarded by mutex
+    std::vector<std::vector<float>> freeBuffers;  ///< Recycled xyz arrays, guarded by mutex
+    bool                            stopping = false;
+
+    // I/O thread only (and close() after the join)
+    std::vector<uint64_t> frameOffsets;
+    std::vector<uint8_t>  encoded;
+    uint64_t              offset = 0;
+    bool                  failed = false;
+};
+
+// MARK: - Reader
+class ClothCacheReader
+{
+public:
+    ClothCacheReader() = default;
+    ~ClothCacheReader() { close(); }
+
+    ClothCacheReader(const ClothCacheReader&)            = delete;
+    ClothCacheReader& operator=(const ClothCacheReader&) = delete;
+
+    /// Map path and index its frames.
+    /// @return false (and prints to std::cerr) if it is not a valid cache
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen()        const { return data != nullptr; }
+    int  getRows()       const { return header.rows; }
+    int  getCols()       const { return header.cols; }
+    int  getParticleCount() const { return header.rows * header.cols; }   ///< open() checked it fits
+    int  getFrameCount() const { return (int)frames.size(); }
+    uint32_t getFlags()  const { return header.flags; }
+
+    /// Static triangle indices and pinned grid indices, pointing into the mapping
+    const uint32_t* getIndices()     const { return indices; }
+    int             getIndexCount()  const { return (int)header.indexCount; }
+    const int32_t*  getPinned()      const { return pinned; }
+    int             getPinnedCount() const { return (int)header.pinnedCount; }
+
+    float  getFrameTime(int frame) const { return frameHeader(frame).time; }
+    size_t getFrameBytes(int frame) const { return sizeof(CacheFrameHeader) + frameHeader(frame).payloadBytes; }
+
+    /// Decode frame into xyz (3 floats per particle, grid order), written
+    /// sequentially so xyz may be a mapped vertex buffer. If pinnedXyz is
+    /// given, the pinned particles' positions go there too, in getPinned() order.
+    /// @return false if frame is out of range or its block is malformed
+    bool readFrame(int frame, float* xyz, float* pinnedXyz = nullptr) const;
+
+private:
+    const CacheFrameHeader& frameHeader(int frame) const
+    {
+        return *reinterpret_cast<const CacheFrameHeader*>(data + frames[frame]);
+    }
+
+    const uint8_t*  data = nullptr;    ///< Whole file
+    size_t          size = 0;
+    bool            mapped = false;    ///< data is an mmap (else heap copy)
+    CacheHeader     header = {};
+    const uint32_t* indices = nullptr;
+    const int32_t*  pinned  = nullptr;
+    std::vector<uint64_t> frames;      ///< Offset of each CacheFrameHeader
+};
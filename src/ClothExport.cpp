@@ -0,0 +1,108 @@
+#include "ClothExport.h"
+
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+// MARK: OBJ export
+/// Uses stdio with a large buffer: at 512² this is ~260k vertex lines, where
+/// iostream formatting would dominate the write.
+namespace
+{
+    /// writeVertices(f) prints the rows * cols `v` lines in grid order
+    template <class WriteVertices>
+    bool writeGridObj(const std::string& path, int rows, int cols, float time, WriteVertices&& writeVertices)
+    {
+        std::FILE* f = std::fopen(path.c_str(), "w");
+        if (!f) {
+            std::cerr << "✗ Could not open " << path << " for writing\n";
+            return false;
+        }
+        std::setvbuf(f, nullptr, _IOFBF, 1 << 20);
+
+        std::fprintf(f, "# clothsim %dx%d t=%.6f\n", rows, cols, time);
+        writeVertices(f);
+
+        // OBJ indices are 1-based
+        auto idx = [cols](int row, int col) { return row * cols + col + 1; };
+        for (int r = 0; r < rows - 1; ++r)
+        {
+            for (int c = 0; c < cols - 1; ++c)
+            {
+                std::fprintf(f, "f %d %d %d\n", idx(r, c),     idx(r + 1, c),     idx(r, c + 1));
+                std::fprintf(f, "f %d %d %d\n", idx(r + 1, c), idx(r + 1, c + 1), idx(r, c + 1));
+            }
+        }
+
+        bool ok = std::ferror(f) == 0;
+        ok = (std::fclose(f) == 0) && ok;
+        if (!ok)
+            std::cerr << "✗ Failed while writing " << path << "\n";
+        return ok;
+    }
+}
+
+bool writeClothObj(const Cloth& cloth, const std::string& path)
+{
+    const ParticleSoA& s = cloth.getParticleData();
+    return writeGridObj(path, cloth.getRows(), cloth.getCols(), cloth.globalTime, [&](std::FILE* f) {
+        // Vertices in grid order regardless of the store layout
+        for (int slot : cloth.getGridToSlot())
+            std::fprintf(f, "v %.6f %.6f %.6f\n", s.posX[slot], s.posY[slot], s.posZ[slot]);
+    });
+}
+
+bool writeCacheFrameObj(const ClothCacheReader& cache, int frame, const std::string& path)
+{
+    std::vector<float> xyz((size_t)cache.getParticleCount() * 3);
+    if (!cache.readFrame(frame, xyz.data())) {
+        std::cerr << "✗ Could not decode cache frame " << frame << "\n";
+        return false;
+    }
+    return writeGridObj(path, cache.getRows(), cache.getCols(), cache.getFrameTime(frame), [&](std::FILE* f) {
+        for (size_t i = 0; i < xyz.size(); i += 3)
+            std::fprintf(f, "v %.6f %.6f %.6f\n", xyz[i], xyz[i + 1], xyz[i + 2]);
+    });
+}
+
+// MARK: Checkpoints
+bool writeClothCheckpoint(const Cloth& cloth, const std::string& path)
+{
+    const std::vector<std::uint8_t> blob = cloth.saveState();
+    const std::string tmp = path + ".tmp";
+
+    std::FILE* f = std::fopen(tmp.c_str(), "wb");
+    if (!f) {
+        std::cerr << "✗ Could not open " << tmp << " for writing\n";
+        return false;
+    }
+    bool ok = std::fwrite(blob.data(), 1, blob.size(), f) == blob.size();
+    ok = (std::fclose(f) == 0) && ok;
+    ok = ok && std::rename(tmp.c_str(), path.c_str()) == 0;
+    if (!ok) {
+        std::remove(tmp.c_str());
+        std::cerr << "✗ Failed while writing " << path << "\n";
+    }
+    return ok;
+}
+
+bool readClothCheckpoint(Cloth& cloth, const std::string& path)
+{
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) {
+        std::cerr << "✗ Could not open " << path << "\n";
+        return false;
+    }
+    std::vector<std::uint8_t> blob;
+    std::uint8_t chunk[1 << 16];
+    for (size_t n; (n = std::fread(chunk, 1, sizeof(chunk), f)) > 0; )
+        blob.insert(blob.end(), chunk, chunk + n);
+    const bool readOk = std::ferror(f) == 0;
+    std::fclose(f);
+
+    if (!readOk || !cloth.restoreState(blob)) {
+        std::cerr << "✗ " << path << " is not a usable cloth checkpoint\n";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Cloth.h"
+#include "ClothCache.h"
+
+#include <string>
+
+/// @file ClothExport.h
+/// Write cloth state to disk from tools that have no renderer.
+///
+/// **Wavefront OBJ:**
+/// One `v x y z` line per particle in grid order (row-major), then two
+/// triangles per grid quad with the same winding as the viewer's mesh:
+///   (r, c), (r+1, c), (r, c+1)  and  (r+1, c), (r+1, c+1), (r, c+1)
+/// Readable by any DCC tool for inspecting a drape.
+///
+/// **Checkpoints:**
+/// Cloth::saveState() blobs as files, for resuming a batch job or
+/// warm-starting one from a settled drape.
+
+/// Write the current particle positions of `cloth` as an OBJ mesh.
+/// @return false (and prints to std::cerr) if the file cannot be written
+bool writeClothObj(const Cloth& cloth, const std::string& path);
+
+/// Write frame `frame` of an open cache as an OBJ mesh, in the same format:
+/// an unquantised cache's last frame matches writeClothObj() of that step.
+/// @return false (and prints to std::cerr) if the frame is malformed or
+/// the file cannot be written
+bool writeCacheFrameObj(const ClothCacheReader& cache, int frame, const std::string& path);
+
+/// Write cloth.saveState() to path. Goes through path + ".tmp" and a rename,
+/// so an interrupted write never leaves a truncated checkpoint behind.
+/// @return false (and prints to std::cerr) if the file cannot be written
+bool writeClothCheckpoint(const Cloth& cloth, const std::string& path);
+
+/// Restore cloth from a checkpoint file (Cloth::restoreState()).
+/// @return false (and prints to std::cerr) if it cannot be read or restored
+bool readClothCheckpoint(Cloth& cloth, const std::string& path);
@@ -0,0 +1,320 @@
+#include "ClothKernels.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define CLOTHSIM_X86 1
+    #include <immintrin.h>
+    #if defined(_MSC_VER) && !defined(__clang__)
+        #include <intrin.h>
+        #define CLOTHSIM_TARGET_AVX2
+    #else
+        #define CLOTHSIM_TARGET_AVX2 __attribute__((target("avx2")))
+    #endif
+#elif defined(__aarch64__) || defined(_M_ARM64) || defined(__ARM_NEON)
+    #define CLOTHSIM_NEON 1
+    #include <arm_neon.h>
+#endif
+
+namespace ClothKernels
+{
+namespace
+{
+    /// Per-axis kernel signatures. Each kernel is called once per axis (x, y, z)
+    /// so it streams just the arrays of that component.
+    using ExternalAxisFn = void (*)(float* f, const float* v, const float* m, const float* invM,
+                                    int begin, int end, float accel, float air);
+    using VerletAxisFn   = void (*)(float* x, float* xPrev, float* v, const float* f,
+                                    const float* invM, int begin, int end, float dt2, float inv2dt);
+
+    // MARK: Scalar
+    void externalAxisScalar(float* f, const float* v, const float* m, const float* invM,
+                            int begin, int end, float accel, float air)
+    {
+        for (int i = begin; i < end; ++i)
+        {
+            float active = invM[i] > 0.f ? 1.f : 0.f;
+            f[i] = active * (accel * m[i] - air * v[i]);
+        }
+    }
+
+    void verletAxisScalar(float* x, float* xPrev, float* v, const float* f,
+                          const float* invM, int begin, int end, float dt2, float inv2dt)
+    {
+        for (int i = begin; i < end; ++i)
+        {
+            float moving = invM[i] > 0.f ? 1.f : 0.f;
+            float newX   = x[i] + moving * (x[i] - xPrev[i] + f[i] * invM[i] * dt2);
+            v[i]     = moving * (newX - xPrev[i]) * inv2dt;
+            xPrev[i] = x[i];
+            x[i]     = newX;
+        }
+    }
+
+#if CLOTHSIM_X86
+    // MARK: SSE2
+    void externalAxisSSE2(float* f, const float* v, const float* m, const float* invM,
+                          int begin, int end, float accel, float air)
+    {
+        const __m128 vAccel = _mm_set1_ps(accel);
+        const __m128 vAir   = _mm_set1_ps(air);
+        const __m128 zero   = _mm_setzero_ps();
+        int i = begin;
+        for (; i + 4 <= end; i += 4)
+        {
+            __m128 mask = _mm_cmpgt_ps(_mm_loadu_ps(invM + i), zero);
+            __m128 res  = _mm_sub_ps(_mm_mul_ps(vAccel, _mm_loadu_ps(m + i)),
+                                     _mm_mul_ps(vAir,   _mm_loadu_ps(v + i)));
+            _mm_storeu_ps(f + i, _mm_and_ps(mask, res));
+        }
+        externalAxisScalar(f, v, m, invM, i, end, accel, air);
+    }
+
+    void verletAxisSSE2(float* x, float* xPrev, float* v, const float* f,
+                        const float* invM, int begin, int end, float dt2, float inv2dt)
+    {
+        const __m128 vDt2    = _mm_set1_ps(dt2);
+        const __m128 vInv2dt = _mm_set1_ps(inv2dt);
+        const __m128 zero    = _mm_setzero_ps();
+        int i = begin;
+        for (; i + 4 <= end; i += 4)
+        {
+            __m128 w    = _mm_loadu_ps(invM + i);
+            __m128 mask = _mm_cmpgt_ps(w, zero);
+            __m128 xi   = _mm_loadu_ps(x + i);
+            __m128 xp   = _mm_loadu_ps(xPrev + i);
+            __m128 step = _mm_add_ps(_mm_sub_ps(xi, xp),
+                                     _mm_mul_ps(_mm_mul_ps(_mm_loadu_ps(f + i), w), vDt2));
+            __m128 newX = _mm_add_ps(xi, _mm_and_ps(mask, step));
+            __m128 vel  = _mm_mul_ps(_mm_sub_ps(newX, xp), vInv2dt);
+            _mm_storeu_ps(v + i,     _mm_and_ps(mask, vel));
+            _mm_storeu_ps(xPrev + i, xi);
+            _mm_storeu_ps(x + i,     newX);
+        }
+        verletAxisScalar(x, xPrev, v, f, invM, i, end, dt2, inv2dt);
+    }
+
+    // MARK: AVX2
+    CLOTHSIM_TARGET_AVX2
+    void externalAxisAVX2(float* f, const float* v, const float* m, const float* invM,
+                          int begin, int end, float accel, float air)
+    {
+        const __m256 vAccel = _mm256_set1_ps(accel);
+        const __m256 vAir   = _mm256_set1_ps(air);
+        const __m256 zero   = _mm256_setzero_ps();
+        int i = begin;
+        for (; i + 8 <= end; i += 8)
+        {
+            __m256 mask = _mm256_cmp_ps(_mm256_loadu_ps(invM + i), zero, _CMP_GT_OQ);
+            __m256 res  = _mm256_sub_ps(_mm256_mul_ps(vAccel, _mm256_loadu_ps(m + i)),
+                                        _mm256_mul_ps(vAir,   _mm256_loadu_ps(v + i)));
+            _mm256_storeu_ps(f + i, _mm256_and_ps(mask, res));
+        }
+        externalAxisScalar(f, v, m, invM, i, end, accel, air);
+    }
+
+    CLOTHSIM_TARGET_AVX2
+    void verletAxisAVX2(float* x, float* xPrev, float* v, const float* f,
+                        const float* invM, int begin, int end, float dt2, float inv2dt)
+    {
+        const __m256 vDt2    = _mm256_set1_ps(dt2);
+        const __m256 vInv2dt = _mm256_set1_ps(inv2dt);
+        const __m256 zero    = _mm256_setzero_ps();
+        int i = begin;
+        for (; i + 8 <= end; i += 8)
+        {
+            __m256 w    = _mm256_loadu_ps(invM + i);
+            __m256 mask = _mm256_cmp_ps(w, zero, _CMP_GT_OQ);
+            __m256 xi   = _mm256_loadu_ps(x + i);
+            __m256 xp   = _mm256_loadu_ps(xPrev + i);
+            __m256 step = _mm256_add_ps(_mm256_sub_ps(xi, xp),
+                                        _mm256_mul_ps(_mm256_mul_ps(_mm256_loadu_ps(f + i), w), vDt2));
+            __m256 newX = _mm256_add_ps(xi, _mm256_and_ps(mask, step));
+            __m256 vel  = _mm256_mul_ps(_mm256_sub_ps(newX, xp), vInv2dt);
+            _mm256_storeu_ps(v + i,     _mm256_and_ps(mask, vel));
+            _mm256_storeu_ps(xPrev + i, xi);
+            _mm256_storeu_ps(x + i,     newX);
+        }
+        verletAxisScalar(x, xPrev, v, f, invM, i, end, dt2, inv2dt);
+    }
+
+    bool cpuHasAVX2()
+    {
+    #if defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) return false;
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx     = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx) return false;
+        if ((_xgetbv(0) & 0x6) != 0x6) return false;   // OS saves XMM + YMM state
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+    #else
+        return __builtin_cpu_supports("avx2");          // includes the OS XSAVE check
+    #endif
+    }
+
+    bool cpuHasSSE2()
+    {
+    #if defined(__x86_64__) || defined(_M_X64)
+        return true;                                    // part of the x86-64 baseline
+    #elif defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+        __cpuid(info, 1);
+        return (info[3] & (1 << 26)) != 0;
+    #else
+        return __builtin_cpu_supports("sse2");
+    #endif
+    }
+#endif // CLOTHSIM_X86
+
+#if CLOTHSIM_NEON
+    // MARK: NEON
+    void externalAxisNEON(float* f, const float* v, const float* m, const float* invM,
+                          int begin, int end, float accel, float air)
+    {
+        const float32x4_t vAccel = vdupq_n_f32(accel);
+        const float32x4_t vAir   = vdupq_n_f32(air);
+        const float32x4_t zero   = vdupq_n_f32(0.f);
+        int i = begin;
+        for (; i + 4 <= end; i += 4)
+        {
+            uint32x4_t  mask = vcgtq_f32(vld1q_f32(invM + i), zero);
+            float32x4_t res  = vsubq_f32(vmulq_f32(vAccel, vld1q_f32(m + i)),
+                                         vmulq_f32(vAir,   vld1q_f32(v + i)));
+            vst1q_f32(f + i, vreinterpretq_f32_u32(vandq_u32(mask, vreinterpretq_u32_f32(res))));
+        }
+        externalAxisScalar(f, v, m, invM, i, end, accel, air);
+    }
+
+    void verletAxisNEON(float* x, float* xPrev, float* v, const float* f,
+                        const float* invM, int begin, int end, float dt2, float inv2dt)
+    {
+        const float32x4_t vDt2    = vdupq_n_f32(dt2);
+        const float32x4_t vInv2dt = vdupq_n_f32(inv2dt);
+        const float32x4_t zero    = vdupq_n_f32(0.f);
+        int i = begin;
+        for (; i + 4 <= end; i += 4)
+        {
+            float32x4_t w    = vld1q_f32(invM + i);
+            uint32x4_t  mask = vcgtq_f32(w, zero);
+            float32x4_t xi   = vld1q_f32(x + i);
+            float32x4_t xp   = vld1q_f32(xPrev + i);
+            // Separate mul + add (no vfmaq) to match the scalar rounding exactly
+            float32x4_t step = vaddq_f32(vsubq_f32(xi, xp),
+                                         vmulq_f32(vmulq_f32(vld1q_f32(f + i), w), vDt2));
+            step             = vreinterpretq_f32_u32(vandq_u32(mask, vreinterpretq_u32_f32(step)));
+            float32x4_t newX = vaddq_f32(xi, step);
+            float32x4_t vel  = vmulq_f32(vsubq_f32(newX, xp), vInv2dt);
+            vst1q_f32(v + i,     vreinterpretq_f32_u32(vandq_u32(mask, vreinterpretq_u32_f32(vel))));
+            vst1q_f32(xPrev + i, xi);
+            vst1q_f32(x + i,     newX);
+        }
+        verletAxisScalar(x, xPrev, v, f, invM, i, end, dt2, inv2dt);
+    }
+#endif // CLOTHSIM_NEON
+
+    // MARK: Dispatch
+    struct KernelTable
+    {
+        Isa            isa      = Isa::Scalar;
+        ExternalAxisFn external = externalAxisScalar;
+        VerletAxisFn   verlet   = verletAxisScalar;
+    };
+
+    KernelTable makeTable(Isa isa)
+    {
+        KernelTable t;
+        t.isa = isa;
+        switch (isa)
+        {
+#if CLOTHSIM_X86
+        case Isa::SSE2: t.external = externalAxisSSE2; t.verlet = verletAxisSSE2; break;
+        case Isa::AVX2: t.external = externalAxisAVX2; t.verlet = verletAxisAVX2; break;
+#endif
+#if CLOTHSIM_NEON
+        case Isa::NEON: t.external = externalAxisNEON; t.verlet = verletAxisNEON; break;
+#endif
+        default:        t.isa = Isa::Scalar; break;
+        }
+        return t;
+    }
+
+    Isa detectBestIsa()
+    {
+        if (isaSupported(Isa::AVX2)) return Isa::AVX2;
+        if (isaSupported(Isa::NEON)) return Isa::NEON;
+        if (isaSupported(Isa::SSE2)) return Isa::SSE2;
+        return Isa::Scalar;
+    }
+
+    /// Selected once, on first use. setIsa() may replace it between steps.
+    KernelTable& table()
+    {
+        static KernelTable t = makeTable(detectBestIsa());
+        return t;
+    }
+} // namespace
+
+bool isaSupported(Isa isa)
+{
+    switch (isa)
+    {
+    case Isa::Scalar: return true;
+#if CLOTHSIM_X86
+    case Isa::SSE2:   return cpuHasSSE2();
+    case Isa::AVX2:   return cpuHasAVX2();
+#endif
+#if CLOTHSIM_NEON
+    case Isa::NEON:   return true;
+#endif
+    default:          return false;
+    }
+}
+
+Isa activeIsa()
+{
+    return table().isa;
+}
+
+bool setIsa(Isa isa)
+{
+    if (!isaSupported(isa)) return false;
+    table() = makeTable(isa);
+    return true;
+}
+
+const char* isaName(Isa isa)
+{
+    switch (isa)
+    {
+    case Isa::Scalar: return "Scalar";
+    case Isa::SSE2:   return "SSE2";
+    case Isa::AVX2:   return "AVX2";
+    case Isa::NEON:   return "NEON";
+    }
+    return "Unknown";
+}
+
+// MARK: Public entry points
+void externalForces(ParticleSoA& s, int begin, int end, const glm::vec3& accel, float airDamping)
+{
+    const KernelTable& t = table();
+    const float* m    = s.mass.data();
+    const float* invM = s.invMass.data();
+    t.external(s.forceX.data(), s.velX.data(), m, invM, begin, end, accel.x, airDamping);
+    t.external(s.forceY.data(), s.velY.data(), m, invM, begin, end, accel.y, airDamping);
+    t.external(s.forceZ.data(), s.velZ.data(), m, invM, begin, end, accel.z, airDamping);
+}
+
+void verlet(ParticleSoA& s, int begin, int end, float dt)
+{
+    const KernelTable& t = table();
+    const float  dt2    = dt * dt;
+    const float  inv2dt = 1.f / (2.f * dt);
+    const float* invM   = s.invMass.data();
+    t.verlet(s.posX.data(), s.prevX.data(), s.velX.data(), s.forceX.data(), invM, begin, end, dt2, inv2dt);
+    t.verlet(s.posY.data(), s.prevY.data(), s.velY.data(), s.forceY.data(), invM, begin, end, dt2, inv2dt);
+    t.verlet(s.posZ.data(), s.prevZ.data(), s.velZ.data(), s.forceZ.data(), invM, begin, end, dt2, inv2dt);
+}
+} // namespace ClothKernels
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "ParticleSoA.h"
+
+#include <glm/glm.hpp>
+
+/// @file ClothKernels.h
+/// SIMD kernels for the per-particle phases of Cloth::update.
+///
+/// **Kernels:**
+/// - externalForces(): F = mask * (m * a_ext - airDamping * v)
+///   where a_ext = gravity + wind (uniform over the cloth this step)
+/// - verlet(): x_new = x + mask * (x - x_prev + F * invMass * dt²),
+///   v = mask * (x_new - x_prev) / (2*dt), x_prev = x, x = x_new
+///
+/// mask = (invMass > 0): pinned particles are handled with a compare + AND
+/// instead of a branch, so every lane does the same work.
+///
+/// **Instruction sets:**
+/// - Scalar: portable fallback, also used for loop tails
+/// - SSE2:   4 lanes (baseline on every x86-64 CPU)
+/// - AVX2:   8 lanes, selected at runtime when the CPU and OS support it
+/// - NEON:   4 lanes (always available on AArch64, e.g. Apple Silicon)
+///
+/// The best supported set is picked on first use. Every variant evaluates the
+/// same expression in the same order with separate multiplies and adds (no
+/// FMA), so the SIMD paths reproduce the scalar results.
+namespace ClothKernels
+{
+    enum class Isa
+    {
+        Scalar,
+        SSE2,
+        AVX2,
+        NEON
+    };
+
+    /// Instruction set currently used by the kernels.
+    Isa activeIsa();
+
+    /// Force a specific instruction set (e.g. for benchmarking).
+    /// Returns false and leaves the selection unchanged if unsupported here.
+    bool setIsa(Isa isa);
+
+    /// True if this build/CPU can run the given instruction set.
+    bool isaSupported(Isa isa);
+
+    /// Human-readable name, e.g. "AVX2".
+    const char* isaName(Isa isa);
+
+    /// Overwrite forces in [begin, end) with gravity/wind plus air damping.
+    /// @param accel      External acceleration (gravity + wind), m/s²
+    /// @param airDamping Linear drag coefficient
+    void externalForces(ParticleSoA& s, int begin, int end,
+                        const glm::vec3& accel, float airDamping);
+
+    /// Verlet step for particles in [begin, end). Reads force, writes pos/prev/vel.
+    void verlet(ParticleSoA& s, int begin, int end, float dt);
+}
@@ -0,0 +1,105 @@
+#include "ClothLod.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    /// Catmull-Rom weights of the four taps around t in [0, 1)
+    inline void catmullRom(float t, float w[4])
+    {
+        const float t2 = t * t;
+        const float t3 = t2 * t;
+        w[0] = 0.5f * (-t3 + 2.f * t2 - t);
+        w[1] = 0.5f * (3.f * t3 - 5.f * t2 + 2.f);
+        w[2] = 0.5f * (-3.f * t3 + 4.f * t2 + t);
+        w[3] = 0.5f * (t3 - t2);
+    }
+
+    /// Source taps and weights for destination index d of dstCount points
+    inline void taps(int d, int dstCount, int srcCount, int idx[4], float w[4])
+    {
+        const float u  = dstCount > 1 ? (float)d * (srcCount - 1) / (dstCount - 1) : 0.f;
+        const int   i0 = std::min((int)u, srcCount - 2);
+        catmullRom(u - i0, w);
+        for (int k = 0; k < 4; ++k)
+            idx[k] = std::clamp(i0 - 1 + k, 0, srcCount - 1);
+    }
+}
+
+namespace ClothLod
+{
+glm::ivec2 gridSize(int displayRows, int displayCols, int level)
+{
+    if (level <= 0) return { displayRows, displayCols };
+
+    const int segments = std::min(displayCols - 1,
+                                  std::max(LOD_MIN_SEGMENTS, (displayCols - 1) >> std::min(level, 30)));
+    const int rowSegments = (int)std::lround((float)(displayRows - 1) * segments / (displayCols - 1));
+    return { std::clamp(rowSegments, 1, displayRows - 1) + 1, segments + 1 };
+}
+
+void resample(const float* src, int srcRows, int srcCols,
+              float* dst, int dstRows, int dstCols, int rowBegin, int rowEnd)
+{
+    for (int r = rowBegin; r < rowEnd; ++r)
+    {
+        int   ri[4];
+        float rw[4];
+        taps(r, dstRows, srcRows, ri, rw);
+
+        float* out = dst + (size_t)r * dstCols * 3;
+        for (int c = 0; c < dstCols; ++c)
+        {
+            int   ci[4];
+            float cw[4];
+            taps(c, dstCols, srcCols, ci, cw);
+
+            float x = 0.f, y = 0.f, z = 0.f;
+            for (int a = 0; a < 4; ++a)
+            {
+                const float* row = src + (size_t)ri[a] * srcCols * 3;
+                float rx = 0.f, ry = 0.f, rz = 0.f;
+                for (int b = 0; b < 4; ++b)
+                {
+                    const float* p = row + ci[b] * 3;
+                    rx += cw[b] * p[0];
+                    ry += cw[b] * p[1];
+                    rz += cw[b] * p[2];
+                }
+                x += rw[a] * rx;
+                y += rw[a] * ry;
+                z += rw[a] * rz;
+            }
+            out[c * 3 + 0] = x;
+            out[c * 3 + 1] = y;
+            out[c * 3 + 2] = z;
+        }
+    }
+}
+
+int mapIndex(int g, int srcRows, int srcCols, int dstRows, int dstCols)
+{
+    const int r = g / srcCols;
+    const int c = g - r * srcCols;
+    const int dr = srcRows > 1 ? (int)std::lround((float)r * (dstRows - 1) / (srcRows - 1)) : 0;
+    const int dc = srcCols > 1 ? (int)std::lround((float)c * (dstCols - 1) / (srcCols - 1)) : 0;
+    return dr * dstCols + dc;
+}
+
+int chooseLevel(int displayRows, int displayCols, float screenPixels, int current)
+{
+    auto segments = [&](int level) { return gridSize(displayRows, displayCols, level).y - 1; };
+    const float wanted = screenPixels / LOD_PIXELS_PER_CELL;   // Cells the screen can resolve
+
+    int level = std::clamp(current, 0, LOD_MAX_LEVEL);
+    // Coarser while the next level still resolves the screen, with margin
+    while (level < LOD_MAX_LEVEL && segments(level + 1) < segments(level) &&
+           segments(level + 1) >= wanted * LOD_HYSTERESIS)
+        ++level;
+    // Finer while this level is visibly too coarse
+    while (level > 0 && segments(level) * LOD_HYSTERESIS < wanted)
+        --level;
+    return level;
+}
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Constants.h"
+
+#include <glm/glm.hpp>
+
+/// @file ClothLod.h
+/// Grid resampling and level selection for level-of-detail cloth
+/// (Cloth::setLodLevel): a cloth simulates on a coarse grid and is drawn on
+/// its full-resolution display grid.
+///
+/// **Levels:**
+/// Level 0 is the display grid itself. Each further level halves the
+/// number of cells across (at least LOD_MIN_SEGMENTS) and picks the row
+/// count that keeps the cells square, so the spring network stays regular.
+///
+/// **Resampling:**
+/// Separable Catmull-Rom bicubic over the regular grid, indices clamped at
+/// the border. It interpolates: wherever a destination grid point falls on
+/// a source grid point (corners, and every 2^level-th point when the sizes
+/// line up), it reproduces it exactly; in between it is C¹, so the
+/// upsampled mesh and its shader normals stay smooth. The same function
+/// carries positions down to a coarser grid when the level changes.
+namespace ClothLod
+{
+    /// Simulated rows × cols (x = rows, y = cols) at level for a
+    /// displayRows × displayCols grid. Level 0 returns the display size.
+    glm::ivec2 gridSize(int displayRows, int displayCols, int level);
+
+    /// Resample an xyz grid (3 floats per point, row-major) of
+    /// srcRows × srcCols onto dstRows × dstCols spanning the same
+    /// parameter range. Writes rows [rowBegin, rowEnd) of dst only, so
+    /// callers can split the work across threads.
+    void resample(const float* src, int srcRows, int srcCols,
+                  float* dst, int dstRows, int dstCols, int rowBegin, int rowEnd);
+
+    /// Whole-grid resample().
+    inline void resample(const float* src, int srcRows, int srcCols,
+                         float* dst, int dstRows, int dstCols)
+    {
+        resample(src, srcRows, srcCols, dst, dstRows, dstCols, 0, dstRows);
+    }
+
+    /// Grid index on dstRows × dstCols nearest to grid index g of srcRows × srcCols.
+    int mapIndex(int g, int srcRows, int srcCols, int dstRows, int dstCols);
+
+    /// Level for a cloth whose display grid spans screenPixels across, so
+    /// a simulated cell covers about LOD_PIXELS_PER_CELL pixels. Moves away
+    /// from current only past the LOD_HYSTERESIS margin, so a cloth at a
+    /// threshold distance does not switch every frame.
+    int chooseLevel(int displayRows, int displayCols, float screenPixels, int current);
+}
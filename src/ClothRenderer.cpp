@@ -0,0 +1,432 @@
+#include "ClothRenderer.h"
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+// GL 4.4 / GL_ARB_buffer_storage is not part of the 3.3 core loader, so the
+// entry point and flags are fetched by hand when the context offers them.
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT   0x0080
+#endif
+
+namespace
+{
+    typedef void (APIENTRYP BufferStorageProc)(GLenum target, GLsizeiptr size,
+                                               const void* data, GLbitfield flags);
+
+    BufferStorageProc bufferStorage()
+    {
+        static BufferStorageProc proc = []() -> BufferStorageProc {
+            if (!glfwExtensionSupported("GL_ARB_buffer_storage"))
+                return nullptr;
+            return (BufferStorageProc)glfwGetProcAddress("glBufferStorage");
+        }();
+        return proc;
+    }
+
+    const int FLOATS_PER_VERTEX = 3;
+    const int INTS_PER_GRID     = 3;   ///< Attribute 1: first vertex, rows, cols
+
+    /// Texture unit the mesh shaders read positions from
+    const int POSITION_TEXTURE_UNIT = 0;
+}
+
+// MARK: Construction
+ClothRenderer::ClothRenderer()
+    : uploadMode(uploadModeSupported(UploadMode::PersistentRing) ? UploadMode::PersistentRing
+                                                                 : UploadMode::MapRing)
+{
+    // Cloth VAO/EBO — triangulated mesh + points (VBO depends on upload mode)
+    glGenVertexArrays(1, &clothVAO);
+    glGenBuffers(1, &clothEBO);
+    glGenBuffers(1, &gridVBO);
+
+    // Per-vertex pinned flags for the point draw
+    glGenBuffers(1, &pinVBO);
+
+    // Texture buffer view of the cloth VBO, for neighbour fetches in the shader
+    glGenTextures(1, &positionTex);
+}
+
+ClothRenderer::~ClothRenderer()
+{
+    destroyVertexBuffer();
+    glDeleteVertexArrays(1, &clothVAO);
+    glDeleteBuffers(1, &clothEBO);
+    glDeleteBuffers(1, &gridVBO);
+    glDeleteBuffers(1, &pinVBO);
+    glDeleteTextures(1, &positionTex);
+}
+
+// MARK: Upload mode
+bool ClothRenderer::uploadModeSupported(UploadMode mode)
+{
+    return mode != UploadMode::PersistentRing || bufferStorage() != nullptr;
+}
+
+const char* ClothRenderer::uploadModeName(UploadMode mode)
+{
+    switch (mode)
+    {
+        case UploadMode::BufferSubData:  return "glBufferSubData";
+        case UploadMode::MapRing:        return "Mapped ring";
+        case UploadMode::PersistentRing: return "Persistent ring";
+    }
+    return "?";
+}
+
+bool ClothRenderer::setUploadMode(UploadMode mode)
+{
+    if (!uploadModeSupported(mode))
+        return false;
+    if (mode == uploadMode)
+        return true;
+
+    uploadMode = mode;
+    if (vertexCount > 0)
+        rebuild();
+    return true;
+}
+
+// MARK: Buffers
+void ClothRenderer::createVertexBuffer()
+{
+    const bool ring = uploadMode != UploadMode::BufferSubData;
+    const GLsizeiptr frameBytes = (GLsizeiptr)vertexCount * FLOATS_PER_VERTEX * sizeof(float);
+    const GLsizeiptr totalBytes = ring ? frameBytes * RING_SIZE : frameBytes;
+
+    glGenBuffers(1, &clothVBO);
+    glBindVertexArray(clothVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, clothVBO);
+
+    if (uploadMode == UploadMode::PersistentRing) {
+        // Immutable storage, mapped once; coherent so writes need no explicit flush
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        bufferStorage()(GL_ARRAY_BUFFER, totalBytes, nullptr, flags);
+        persistentPtr = (float*)glMapBufferRange(GL_ARRAY_BUFFER, 0, totalBytes, flags);
+    } else {
+        // GL_DYNAMIC_DRAW for per-frame updates
+        glBufferData(GL_ARRAY_BUFFER, totalBytes, nullptr, GL_DYNAMIC_DRAW);
+    }
+
+    // Attribute 0: position (3 floats, stride=12, offset=0)
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, FLOATS_PER_VERTEX * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    // Attribute 1: grid of each vertex, repeated per region so base-vertex
+    // offsets land on the same grid (3 ints, stride=12, offset=0)
+    const int regions = ring ? RING_SIZE : 1;
+    std::vector<GLint> gridData;
+    gridData.reserve((size_t)vertexCount * INTS_PER_GRID * regions);
+    for (int r = 0; r < regions; ++r) {
+        for (const Grid& g : grids) {
+            for (int v = 0; v < g.rows * g.cols; ++v) {
+                gridData.push_back(g.firstVertex);
+                gridData.push_back(g.rows);
+                gridData.push_back(g.cols);
+            }
+        }
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, gridVBO);
+    glBufferData(GL_ARRAY_BUFFER, gridData.size() * sizeof(GLint), gridData.data(), GL_STATIC_DRAW);
+    glVertexAttribIPointer(1, INTS_PER_GRID, GL_INT, INTS_PER_GRID * sizeof(GLint), (void*)0);
+    glEnableVertexAttribArray(1);
+
+    // Attribute 2: pinned flag, nothing pinned until updatePins() (1 float, stride=4)
+    const std::vector<GLfloat> unpinned((size_t)vertexCount * regions, 0.f);
+    glBindBuffer(GL_ARRAY_BUFFER, pinVBO);
+    glBufferData(GL_ARRAY_BUFFER, unpinned.size() * sizeof(GLfloat), unpinned.data(), GL_DYNAMIC_DRAW);
+    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(GLfloat), (void*)0);
+    glEnableVertexAttribArray(2);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, clothEBO);
+    glBindVertexArray(0);
+
+    // One R32F texel per float (RGB32F buffer textures need GL 4.0)
+    GLint maxTexels = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+    if ((GLint64)totalBytes / (GLint64)sizeof(float) > maxTexels)
+        std::cerr << "✗ " << vertexCount << " cloth vertices exceed GL_MAX_TEXTURE_BUFFER_SIZE ("
+                  << maxTexels << " texels); shaded normals will be wrong\n";
+
+    glBindTexture(GL_TEXTURE_BUFFER, positionTex);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_R32F, clothVBO);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+void ClothRenderer::destroyVertexBuffer()
+{
+    for (GLsync& fence : fences) {
+        if (fence) glDeleteSync(fence);
+        fence = nullptr;
+    }
+    if (persistentPtr) {
+        glBindBuffer(GL_ARRAY_BUFFER, clothVBO);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        persistentPtr = nullptr;
+    }
+    if (clothVBO) {
+        glDeleteBuffers(1, &clothVBO);
+        clothVBO = 0;
+    }
+    region = 0;
+}
+
+void ClothRenderer::waitForRegion(int r)
+{
+    if (!fences[r]) return;
+
+    // Normally already signalled: the region was drawn RING_SIZE-1 frames ago
+    GLbitfield flags = 0;
+    for (;;) {
+        GLenum status = glClientWaitSync(fences[r], flags, 1000000000ull);
+        if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED || status == GL_WAIT_FAILED)
+            break;
+        flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    }
+    glDeleteSync(fences[r]);
+    fences[r] = nullptr;
+}
+
+// MARK: Resize
+void ClothRenderer::appendGridIndices(int rows, int cols, std::vector<unsigned int>& out)
+{
+    // Each quad (r, c) becomes two triangles (CCW winding)
+    auto idx = [cols](int row, int col) { return (unsigned int)(row * cols + col); };
+    for (int r = 0; r < rows - 1; ++r) {
+        for (int c = 0; c < cols - 1; ++c) {
+            // Triangle 1: (r, c), (r+1, c), (r, c+1)
+            out.push_back(idx(r,     c));
+            out.push_back(idx(r + 1, c));
+            out.push_back(idx(r,     c + 1));
+            // Triangle 2: (r+1, c), (r+1, c+1), (r, c+1)
+            out.push_back(idx(r + 1, c));
+            out.push_back(idx(r + 1, c + 1));
+            out.push_back(idx(r,     c + 1));
+        }
+    }
+}
+
+
+void ClothRenderer::resize(const WorldSnapshot& world)
+{
+    grids.clear();
+    vertexCount = 0;
+    int indexCount = 0;
+    for (const ClothSnapshot& c : world.cloths) {
+        grids.push_back({ c.rows, c.cols, vertexCount, indexCount });
+        vertexCount += c.rows * c.cols;
+        indexCount  += (c.rows - 1) * (c.cols - 1) * 6;
+    }
+    rebuild();
+}
+
+bool ClothRenderer::layoutMatches(const WorldSnapshot& world) const
+{
+    if (world.cloths.size() != grids.size())
+        return false;
+    for (size_t k = 0; k < grids.size(); ++k)
+        if (world.cloths[k].rows != grids[k].rows || world.cloths[k].cols != grids[k].cols)
+            return false;
+    return true;
+}
+
+void ClothRenderer::rebuild()
+{
+    // Generate indices for every cloth mesh, local to the cloth's grid
+    indices.clear();
+    drawCounts.clear();
+    drawOffsets.clear();
+    for (const Grid& g : grids) {
+        appendGridIndices(g.rows, g.cols, indices);
+        drawCounts.push_back((GLsizei)(indices.size() - g.firstIndex));
+        drawOffsets.push_back((const void*)(g.firstIndex * sizeof(unsigned int)));
+    }
+    drawBases.assign(grids.size(), 0);
+
+    // Immutable storage can't be resized, so the VBO is always recreated
+    destroyVertexBuffer();
+    createVertexBuffer();
+
+    glBindVertexArray(clothVAO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    glBindVertexArray(0);
+
+    staging.assign(uploadMode == UploadMode::BufferSubData ? vertexCount * FLOATS_PER_VERTEX : 0, 0.f);
+
+    // createVertexBuffer() cleared the flags; pin lists sized for the worst
+    // case (every particle pinned) so updatePins() never reallocates
+    pinnedVertices.clear();
+    pinnedVertices.reserve(vertexCount);
+    pinScratch.clear();
+    pinScratch.reserve(vertexCount);
+    pinFlags.assign(vertexCount, 0.f);
+    pinnedCount = 0;
+}
+
+// MARK: Upload
+void ClothRenderer::writePositions(float* dst, const WorldSnapshot& prev,
+                                   const WorldSnapshot& curr, float alpha)
+{
+    // Snapshots are already xyz-interleaved like the VBO; written
+    // sequentially because dst may be write-combined memory
+    for (size_t k = 0; k < grids.size(); ++k) {
+        const ClothSnapshot& cs = curr.cloths[k];
+        const int count = (int)cs.positions.size();
+        const float* b = cs.positions.data();
+        float*       d = dst + (size_t)grids[k].firstVertex * FLOATS_PER_VERTEX;
+        if (alpha >= 1.f || k >= prev.cloths.size() || (int)prev.cloths[k].positions.size() != count) {
+            std::memcpy(d, b, count * sizeof(float));
+            continue;
+        }
+        const float* a = prev.cloths[k].positions.data();
+        for (int i = 0; i < count; ++i)
+            d[i] = a[i] + (b[i] - a[i]) * alpha;
+    }
+}
+
+template <class WriteFn>
+bool ClothRenderer::uploadVertices(WriteFn&& write)
+{
+    const int n = vertexCount;
+    const GLsizeiptr frameBytes = (GLsizeiptr)n * FLOATS_PER_VERTEX * sizeof(float);
+
+    // On a failed write the last frame's region stays current: its
+    // contents are untouched, while the new one may be half written (or,
+    // mapped with INVALIDATE_RANGE, undefined)
+    const int last = region;
+    bool ok = true;
+    switch (uploadMode)
+    {
+        case UploadMode::BufferSubData:
+            ok = write(staging.data());
+            if (ok) {
+                glBindBuffer(GL_ARRAY_BUFFER, clothVBO);
+                glBufferSubData(GL_ARRAY_BUFFER, 0, frameBytes, staging.data());
+            }
+            break;
+
+        case UploadMode::MapRing: {
+            region = (region + 1) % RING_SIZE;
+            waitForRegion(region);
+            glBindBuffer(GL_ARRAY_BUFFER, clothVBO);
+            float* dst = (float*)glMapBufferRange(GL_ARRAY_BUFFER, region * frameBytes, frameBytes,
+                                                  GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT |
+                                                  GL_MAP_INVALIDATE_RANGE_BIT);
+            ok = dst != nullptr;
+            if (dst) {
+                ok = write(dst);
+                glUnmapBuffer(GL_ARRAY_BUFFER);
+            }
+            break;
+        }
+
+        case UploadMode::PersistentRing:
+            region = (region + 1) % RING_SIZE;
+            waitForRegion(region);
+            ok = write(persistentPtr + (size_t)region * n * FLOATS_PER_VERTEX);
+            break;
+    }
+    if (!ok) {
+        region = last;
+        return false;
+    }
+
+    for (size_t k = 0; k < grids.size(); ++k)
+        drawBases[k] = baseVertex() + grids[k].firstVertex;
+    return true;
+}
+
+void ClothRenderer::upload(const WorldSnapshot& prev, const WorldSnapshot& curr, float alpha)
+{
+    if (!layoutMatches(curr))
+        resize(curr);
+
+    if (vertexCount == 0) {
+        pinnedCount = 0;
+        return;
+    }
+    uploadVertices([&](float* dst) { writePositions(dst, prev, curr, alpha); return true; });
+
+    pinScratch.clear();
+    for (size_t k = 0; k < grids.size(); ++k)
+        for (int i : curr.cloths[k].pinned)
+            pinScratch.push_back(grids[k].firstVertex + i);
+    updatePins();
+}
+
+bool ClothRenderer::upload(const ClothCacheReader& cache, int frame)
+{
+    if (grids.size() != 1 || grids[0].rows != cache.getRows() || grids[0].cols != cache.getCols()) {
+        grids.assign(1, { cache.getRows(), cache.getCols(), 0, 0 });
+        vertexCount = cache.getParticleCount();
+        rebuild();
+    }
+
+    // Decoded straight into this frame's region (staging in BufferSubData mode)
+    if (!uploadVertices([&](float* dst) { return cache.readFrame(frame, dst); }))
+        return false;
+
+    pinScratch.assign(cache.getPinned(), cache.getPinned() + cache.getPinnedCount());
+    updatePins();
+    return true;
+}
+
+
+void ClothRenderer::updatePins()
+{
+    if (pinScratch == pinnedVertices) return;
+    pinnedVertices.swap(pinScratch);   // Both keep their reserved capacity
+    pinnedCount = (int)pinnedVertices.size();
+
+    std::fill(pinFlags.begin(), pinFlags.end(), 0.f);
+    for (int v : pinnedVertices)
+        pinFlags[v] = 1.f;
+
+    // Same flags in every region, so base-vertex draws see them (as gridVBO)
+    const bool ring = uploadMode != UploadMode::BufferSubData;
+    const GLsizeiptr regionBytes = (GLsizeiptr)vertexCount * sizeof(GLfloat);
+    glBindBuffer(GL_ARRAY_BUFFER, pinVBO);
+    for (int r = 0; r < (ring ? RING_SIZE : 1); ++r)
+        glBufferSubData(GL_ARRAY_BUFFER, r * regionBytes, regionBytes, pinFlags.data());
+}
+
+void ClothRenderer::endFrame()
+{
+    if (uploadMode == UploadMode::BufferSubData) return;
+
+    if (fences[region]) glDeleteSync(fences[region]);
+    fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+// MARK: Draw
+void ClothRenderer::bindGridUniforms(const Shader& shader) const
+{
+    glActiveTexture(GL_TEXTURE0 + POSITION_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, positionTex);
+    shader.setInt("uPositions", POSITION_TEXTURE_UNIT);
+    shader.setInt("uBaseVertex", baseVertex());
+    shader.setInt("uVertexStride", FLOATS_PER_VERTEX);
+}
+
+void ClothRenderer::drawMesh() const
+{
+    if (grids.empty()) return;
+    glBindVertexArray(clothVAO);
+    glMultiDrawElementsBaseVertex(GL_TRIANGLES, drawCounts.data(), GL_UNSIGNED_INT, drawOffsets.data(),
+                                  (GLsizei)grids.size(), drawBases.data());
+}
+
+void ClothRenderer::drawPoints() const
+{
+    if (vertexCount == 0) return;
+    glBindVertexArray(clothVAO);
+    glDrawArrays(GL_POINTS, baseVertex(), vertexCount);
+}
+
@@ -0,0 +1,185 @@
+#pragma once
+
+#include "ClothCache.h"
+#include "Shader.h"
+#include "SimulationThread.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+/// @file ClothRenderer.h
+/// GPU buffers for drawing every cloth of a ClothWorld: triangulated meshes
+/// and particle points, pinned ones flagged per vertex. Fed from WorldSnapshots, so it never
+/// touches the cloths that the simulation thread owns.
+///
+/// **Sizing:**
+/// Buffers are sized from the snapshot's cloth count and rows/cols, not from
+/// compile-time constants. upload() notices a layout change (a cloth added,
+/// removed or resized) and rebuilds the VBOs, EBO and draw lists before
+/// writing, so the viewer can change the scene at runtime without a restart.
+///
+/// **Vertex arena (clothVBO):**
+/// All cloths share one VAO and one vertex buffer: cloth k's particles are
+/// packed after cloth k-1's, each in its own grid order. Positions only,
+/// 3 floats per particle.
+/// - Attribute 0: position (vec3, offset 0)
+/// - Attribute 1: grid (ivec3 first vertex, rows, cols) from the static
+///   gridVBO, so the shaders know which grid a vertex belongs to
+/// - Attribute 2: pinned flag (float 0 / 1) from pinVBO, read by cloth.vert
+///   to colour pinned particles
+///
+/// **Draws:**
+/// The EBO holds each cloth's local triangle indices back to back, and
+/// drawMesh() issues all cloths in one glMultiDrawElementsBaseVertex, one
+/// sub-draw per cloth whose base vertex is the cloth's first vertex in the
+/// current ring region. drawPoints() is one glDrawArrays over the whole
+/// arena, pinned particles included: cloth.vert picks their colour from
+/// attribute 2, so adding cloths or pins adds no draw calls.
+///
+/// **Pins:**
+/// Pinned sets only change on user action. upload() gathers the pinned
+/// vertices of the snapshot into a reserved scratch list and compares it
+/// with the last one; only a change rewrites pinVBO (every ring region,
+/// like gridVBO). Steady frames make no pin-related GL calls.
+///
+/// **Normals:**
+/// Computed in the vertex shader, not on the CPU. The same VBO is exposed as
+/// an R32F texture buffer; mesh.vert / normalWS.vert fetch the four grid
+/// neighbours of gl_VertexID and take the cross product of the central
+/// differences (one-sided at the border). bindGridUniforms() sets the
+/// texture and the ring region on a shader before drawing.
+///
+/// **Upload modes:**
+/// - BufferSubData:  stage into a CPU vector, then glBufferSubData the whole
+///   VBO. Simple, but the driver may stall if the GPU still reads the buffer.
+/// - MapRing:        GL 3.3 path. The VBO holds RING_SIZE frames; each frame
+///   maps its own region with UNSYNCHRONIZED | INVALIDATE_RANGE and writes
+///   vertices straight into it.
+/// - PersistentRing: same ring, but allocated once with glBufferStorage
+///   (GL 4.4 / GL_ARB_buffer_storage) and kept mapped for its lifetime.
+///
+/// In both ring modes a fence is inserted after the draws that read a region,
+/// and upload() waits on that fence before overwriting it, so there is no
+/// implicit sync and no per-frame heap allocation. Draws offset into the
+/// current region with a base vertex (the region's start is also passed to
+/// the shader as uBaseVertex so neighbour fetches stay inside the region).
+/// The grid attribute is replicated once per region to match.
+class ClothRenderer
+{
+public:
+    enum class UploadMode
+    {
+        BufferSubData,
+        MapRing,
+        PersistentRing
+    };
+
+    /// Frames in flight for the ring modes
+    static constexpr int RING_SIZE = 3;
+
+    /// Requires a current GL context. Picks the best supported upload mode.
+    ClothRenderer();
+    ~ClothRenderer();
+
+    ClothRenderer(const ClothRenderer&)            = delete;
+    ClothRenderer& operator=(const ClothRenderer&) = delete;
+
+    /// (Re)allocate GPU buffers, indices and draw lists for the cloths of
+    /// a snapshot (only their rows/cols are read).
+    void resize(const WorldSnapshot& world);
+
+    /// Upload positions blended from prev to curr by alpha, and the pinned
+    /// flags of curr if they changed. Calls resize() first if the layout changed; a cloth
+    /// of prev is ignored if its size differs from the one in curr.
+    void upload(const WorldSnapshot& prev, const WorldSnapshot& curr, float alpha);
+
+    /// Upload frame `frame` of a cache as the only cloth, decoded straight
+    /// into the mapped ring region (playback, no simulation involved).
+    /// @return false if the frame is malformed; the previous frame stays drawn
+    bool upload(const ClothCacheReader& cache, int frame);
+
+    /// Bind the position texture buffer and set uPositions, uBaseVertex and
+    /// uVertexStride on a mesh shader. Call after shader.use(), before drawMesh().
+    void bindGridUniforms(const Shader& shader) const;
+
+    /// Draw every cloth's triangle mesh in one multi-draw (caller binds the
+    /// shader and sets uniforms).
+    void drawMesh() const;
+
+    /// Draw every particle of every cloth as a point, in one call; pinned
+    /// particles carry attribute 2 = 1.
+    void drawPoints() const;
+
+    /// Fence the region drawn this frame. Call once after the last draw.
+    void endFrame();
+
+    /// Switch upload strategy; reallocates the buffers.
+    /// Returns false and leaves the mode unchanged if unsupported here.
+    bool setUploadMode(UploadMode mode);
+    UploadMode getUploadMode() const { return uploadMode; }
+
+    /// True if the current context can run the given upload mode.
+    static bool uploadModeSupported(UploadMode mode);
+
+    /// Human-readable name, e.g. "Persistent ring".
+    static const char* uploadModeName(UploadMode mode);
+
+    /// Append two CCW triangles per quad of a rows × cols grid, indices
+    /// local to the grid (row-major). Also used by GpuCloth.
+    static void appendGridIndices(int rows, int cols, std::vector<unsigned int>& out);
+
+    int getClothCount()  const { return (int)grids.size(); }
+    int getVertexCount() const { return vertexCount; }
+    int getIndexCount()  const { return (int)indices.size(); }
+    int getPinnedCount() const { return pinnedCount; }
+
+private:
+    /// One cloth's slice of the vertex arena and of the EBO
+    struct Grid
+    {
+        int rows, cols;
+        int firstVertex;
+        int firstIndex;
+    };
+
+    void rebuild();
+    bool layoutMatches(const WorldSnapshot& world) const;
+    void createVertexBuffer();
+    void destroyVertexBuffer();
+    void waitForRegion(int region);
+    void writePositions(float* dst, const WorldSnapshot& prev, const WorldSnapshot& curr, float alpha);
+    /// Advance the ring and let bool write(float* dst) fill this frame's vertices
+    /// (a template so the per-frame lambda is never boxed in a std::function).
+    /// If write returns false, the previous frame's vertices stay current.
+    template <class WriteFn>
+    bool uploadVertices(WriteFn&& write);
+    /// Adopt pinScratch as the pinned set, rewriting pinVBO if it differs
+    void updatePins();
+
+    /// Start of the ring region holding this frame's vertices (0 outside ring modes)
+    int baseVertex() const { return region * vertexCount; }
+
+    GLuint clothVAO  = 0, clothVBO  = 0, clothEBO = 0;
+    GLuint gridVBO   = 0;                    ///< Attribute 1, one copy per ring region
+    GLuint pinVBO    = 0;                    ///< Attribute 2, one copy per ring region
+    GLuint positionTex = 0;                  ///< GL_TEXTURE_BUFFER view of clothVBO
+
+    std::vector<Grid> grids;
+    int vertexCount = 0;                     ///< Particles over all cloths
+    int pinnedCount = 0;
+
+    UploadMode uploadMode;
+    int        region = 0;                   ///< Ring region written by the last upload()
+    GLsync     fences[RING_SIZE] = {};      ///< Signalled when the GPU is done with a region
+    float*     persistentPtr = nullptr;      ///< Whole-ring mapping in PersistentRing mode
+
+    std::vector<unsigned int> indices;     ///< Two CCW triangles per grid quad, local to each cloth
+    std::vector<GLsizei>      drawCounts;  ///< Per cloth: index count
+    std::vector<const void*>  drawOffsets; ///< Per cloth: byte offset of its first index
+    std::vector<GLint>        drawBases;   ///< Per cloth: first vertex in the current region
+    std::vector<float>        staging;     ///< Scratch for BufferSubData mode
+    std::vector<int>          pinnedVertices; ///< Arena indices flagged in pinVBO, in upload order
+    std::vector<int>          pinScratch;     ///< This frame's pinned set, compared with pinnedVertices
+    std::vector<GLfloat>      pinFlags;       ///< Scratch: one region of pinVBO
+};
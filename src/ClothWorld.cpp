@@ -0,0 +1,89 @@
+#include "ClothWorld.h"
+
+#include <algorithm>
+
+// MARK: Cloths
+Cloth& ClothWorld::add(int rows, int cols, float spacing, glm::vec3 origin)
+{
+    auto cloth = std::make_unique<Cloth>(rows, cols, spacing);
+    if (origin != glm::vec3(0.f))
+    {
+        cloth->origin = origin;
+        cloth->reset();
+    }
+    cloth->setThreadPool(threadPool);
+    cloths.push_back(std::move(cloth));
+    graphDirty = true;
+    return *cloths.back();
+}
+
+void ClothWorld::remove(int index)
+{
+    cloths.erase(cloths.begin() + index);
+    graphDirty = true;
+}
+
+void ClothWorld::setThreadPool(ThreadPool* pool)
+{
+    threadPool = pool;
+    for (auto& cloth : cloths)
+        cloth->setThreadPool(pool);
+}
+
+int ClothWorld::getParticleCount() const
+{
+    int n = 0;
+    for (const auto& cloth : cloths)
+        n += cloth->getParticleData().size();
+    return n;
+}
+
+int ClothWorld::getSpringCount() const
+{
+    int n = 0;
+    for (const auto& cloth : cloths)
+        n += (int)cloth->getSprings().size();
+    return n;
+}
+
+// MARK: Update
+void ClothWorld::update(float dt, int steps)
+{
+    if (cloths.empty() || steps <= 0) return;
+
+    if (graphDirty)
+    {
+        graphs.clear();
+        graphDirty = false;
+    }
+    if ((int)graphs.size() < steps)
+        graphs.resize(steps);
+    std::unique_ptr<TaskGraph>& graph = graphs[steps - 1];
+    if (!graph)
+    {
+        graph = std::make_unique<TaskGraph>();
+        buildGraph(*graph, steps);
+    }
+    stepDt = dt;
+    pool().run(*graph);
+}
+
+/// Longest chains first: the thread that starts the biggest cloth is the
+/// one most likely to finish last.
+void ClothWorld::buildGraph(TaskGraph& graph, int steps)
+{
+    std::vector<int> order(cloths.size());
+    for (int i = 0; i < size(); ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [this](int a, int b) {
+        return cloths[a]->getSprings().size() > cloths[b]->getSprings().size();
+    });
+
+    graph.clear();
+    for (int i : order)
+    {
+        Cloth* cloth = cloths[i].get();
+        TaskGraph::TaskId prev = graph.add([this, cloth] { cloth->update(stepDt); });
+        for (int s = 1; s < steps; ++s)
+            prev = graph.add([this, cloth] { cloth->update(stepDt); }, { prev });
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Cloth.h"
+#include "ThreadPool.h"
+
+#include <glm/glm.hpp>
+#include <memory>
+#include <vector>
+
+/// @file ClothWorld.h
+/// A scene of independent Cloth instances (garments, flags) stepped together.
+///
+/// **Ownership:**
+/// The world owns its cloths; add() returns a reference that stays valid
+/// until the cloth is removed or the world is cleared. Cloths do not interact
+/// with each other; each keeps its own colliders and parameters.
+///
+/// **Batched stepping:**
+/// update(dt, steps) runs one TaskGraph on the pool: per cloth a chain of
+/// `steps` Cloth::update tasks, each depending on the previous one, so
+/// cloths advance independently with no world-wide barrier between
+/// substeps. Chains are started largest cloth first, and each cloth's own
+/// parallel loops are chunked onto the same pool, where idle threads steal
+/// them; one big cloth still uses every thread, many small ones run side
+/// by side. Since every Cloth phase is deterministic for any chunking and
+/// any thread, the result does not depend on the thread count or on this
+/// scheduling.
+///
+/// **Threading:**
+/// Like Cloth, a world is stepped from one thread at a time (see
+/// SimulationThread); update() uses the pool set by setThreadPool().
+class ClothWorld
+{
+public:
+    ClothWorld() = default;
+
+    ClothWorld(const ClothWorld&)            = delete;
+    ClothWorld& operator=(const ClothWorld&) = delete;
+
+    /// Add a rows × cols cloth whose initial grid is offset by origin
+    /// (see Cloth::origin). Uses the world's thread pool.
+    Cloth& add(int rows, int cols, float spacing, glm::vec3 origin = glm::vec3(0.f));
+
+    /// Remove cloth `index`; later cloths shift down by one.
+    void remove(int index);
+    void clear() { cloths.clear(); graphDirty = true; }
+
+    int          size() const            { return (int)cloths.size(); }
+    bool         empty() const           { return cloths.empty(); }
+    Cloth&       operator[](int i)       { return *cloths[i]; }
+    const Cloth& operator[](int i) const { return *cloths[i]; }
+
+    /// Advance every cloth by `steps` Cloth::update(dt) calls.
+    void update(float dt, int steps = 1);
+
+    /// Pool for update() and for every cloth, current and future.
+    /// nullptr (the default) means ThreadPool::shared().
+    void setThreadPool(ThreadPool* pool);
+    /// Pool in use (for other parallel work on the stepping thread, e.g.
+    /// WorldSnapshot::capture())
+    ThreadPool& pool() const { return threadPool ? *threadPool : ThreadPool::shared(); }
+
+    int getParticleCount() const;
+    int getSpringCount() const;
+
+private:
+    void buildGraph(TaskGraph& graph, int steps);
+
+    std::vector<std::unique_ptr<Cloth>> cloths;
+    ThreadPool*                         threadPool = nullptr; ///< Non-owning; nullptr = shared pool
+
+    /// Step chains for a batch of k steps at [k - 1], built on first use and
+    /// dropped when the cloths change, so batches of varying length reuse
+    /// their graphs instead of rebuilding (and reallocating) them
+    std::vector<std::unique_ptr<TaskGraph>> graphs;
+    bool      graphDirty = true;
+    float     stepDt     = 0.f;     ///< Read by the graphs' tasks
+};
@@ -0,0 +1,177 @@
+#include "Collider.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+// MARK: - MeshCollider
+MeshCollider::MeshCollider(std::vector<glm::vec3> vertices, std::vector<glm::ivec3> triangles)
+    : vertices(std::move(vertices))
+    , triangles(std::move(triangles))
+{
+    updateFaceNormals();
+    bvh.build(this->vertices, this->triangles);
+}
+
+void MeshCollider::setVertices(const std::vector<glm::vec3>& v)
+{
+    if (v.size() != vertices.size()) {
+        std::cerr << "✗ MeshCollider::setVertices: expected " << vertices.size()
+                  << " vertices, got " << v.size() << "\n";
+        return;
+    }
+    vertices = v;
+    updateFaceNormals();
+    bvh.refit(vertices);
+    ++version;
+}
+
+void MeshCollider::rebuild()
+{
+    bvh.build(vertices, triangles);
+}
+
+void MeshCollider::updateFaceNormals()
+{
+    faceNormals.resize(triangles.size());
+    for (size_t t = 0; t < triangles.size(); ++t)
+    {
+        const glm::ivec3& tri = triangles[t];
+        glm::vec3 n   = glm::cross(vertices[tri.y] - vertices[tri.x], vertices[tri.z] - vertices[tri.x]);
+        float     len = glm::length(n);
+        faceNormals[t] = len > 0.f ? n / len : glm::vec3(0.f, 1.f, 0.f);
+    }
+}
+
+bool MeshCollider::closestPoint(const glm::vec3& p, float maxDist, glm::vec3& point, glm::vec3& normal) const
+{
+    TriangleBvh::Hit hit;
+    if (!bvh.closestPoint(vertices, p, maxDist, hit)) return false;
+    point  = hit.point;
+    normal = faceNormals[hit.triangle];
+    return true;
+}
+
+// MARK: - ColliderSet
+void ColliderSet::clear()
+{
+    spheres.clear();
+    capsules.clear();
+    planes.clear();
+    meshes.clear();
+}
+
+namespace
+{
+    /// Push x out of a sphere of radius r around c (shared by spheres and capsules).
+    bool pushOutOfSphere(glm::vec3& x, const glm::vec3& c, float r, glm::vec3& normal)
+    {
+        glm::vec3 d    = x - c;
+        float     dist = glm::length(d);
+        if (dist >= r) return false;
+        // Exactly at the center there is no direction: push up
+        normal = dist > 1e-6f ? d / dist : glm::vec3(0.f, 1.f, 0.f);
+        x      = c + normal * r;
+        return true;
+    }
+}
+
+/// Planes and analytic shapes are cheap closed forms. Meshes cost one BVH
+/// closest-point query per particle, with a search radius of
+/// thickness + |x - prev| (a particle that started the step outside cannot
+/// be deeper than it moved), so particles far from the mesh are rejected
+/// near the root of the tree.
+bool ColliderSet::resolve(glm::vec3& x, const glm::vec3& prev, float thickness, glm::vec3& normal) const
+{
+    bool moved = false;
+
+    for (const PlaneCollider& pl : planes)
+    {
+        float s = glm::dot(pl.normal, x) - pl.offset;
+        if (s < thickness)
+        {
+            x     += (thickness - s) * pl.normal;
+            normal = pl.normal;
+            moved  = true;
+        }
+    }
+
+    for (const SphereCollider& sp : spheres)
+        moved |= pushOutOfSphere(x, sp.center, sp.radius + thickness, normal);
+
+    for (const CapsuleCollider& cp : capsules)
+    {
+        glm::vec3 ab    = cp.b - cp.a;
+        float     lenSq = glm::dot(ab, ab);
+        float     t     = lenSq > 0.f ? glm::clamp(glm::dot(x - cp.a, ab) / lenSq, 0.f, 1.f) : 0.f;
+        moved |= pushOutOfSphere(x, cp.a + t * ab, cp.radius + thickness, normal);
+    }
+
+    if (!meshes.empty())
+    {
+        const float searchRadius = thickness + glm::length(x - prev);
+        for (const auto& mesh : meshes)
+        {
+            glm::vec3 q, n;
+            if (!mesh->closestPoint(x, searchRadius, q, n)) continue;
+            float s = glm::dot(x - q, n);
+            if (s < thickness)
+            {
+                x     += (thickness - s) * n;
+                normal = n;
+                moved  = true;
+            }
+        }
+    }
+    return moved;
+}
+
+// MARK: - OBJ import
+bool readObjMesh(const std::string& path, std::vector<glm::vec3>& vertices,
+                 std::vector<glm::ivec3>& triangles)
+{
+    std::FILE* f = std::fopen(path.c_str(), "r");
+    if (!f) {
+        std::cerr << "✗ Could not open " << path << " for reading\n";
+        return false;
+    }
+
+    vertices.clear();
+    triangles.clear();
+    char line[1024];
+    std::vector<int> face;
+    while (std::fgets(line, sizeof(line), f))
+    {
+        if (line[0] == 'v' && line[1] == ' ')
+        {
+            glm::vec3 v(0.f);
+            std::sscanf(line + 2, "%f %f %f", &v.x, &v.y, &v.z);
+            vertices.push_back(v);
+        }
+        else if (line[0] == 'f' && line[1] == ' ')
+        {
+            // "f 1 2 3", "f 1/1/1 2/2/2 3/3/3", negative = relative to the end
+            face.clear();
+            for (char* tok = std::strtok(line + 2, " \t\r\n"); tok; tok = std::strtok(nullptr, " \t\r\n"))
+            {
+                int i = std::atoi(tok);
+                face.push_back(i < 0 ? (int)vertices.size() + i : i - 1);
+            }
+            for (size_t k = 2; k < face.size(); ++k)
+                triangles.push_back({ face[0], face[k - 1], face[k] });
+        }
+    }
+    std::fclose(f);
+
+    for (const glm::ivec3& t : triangles)
+    {
+        if (t.x < 0 || t.y < 0 || t.z < 0 || t.x >= (int)vertices.size() ||
+            t.y >= (int)vertices.size() || t.z >= (int)vertices.size()) {
+            std::cerr << "✗ " << path << ": face index out of range\n";
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "TriangleBvh.h"
+
+#include <glm/glm.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// @file Collider.h
+/// Kinematic collision shapes the cloth is pushed out of (one-way: the
+/// colliders are never moved by the cloth).
+///
+/// **Shapes:**
+/// - SphereCollider:  center + radius
+/// - CapsuleCollider: segment a-b swept by a radius (limbs, poles)
+/// - PlaneCollider:   half-space dot(normal, x) < offset is solid
+/// - MeshCollider:    triangle mesh (e.g. a character) with a TriangleBvh;
+///                    animate it with setVertices(), which refits the tree
+///
+/// **Response:**
+/// Each particle is projected to at least `thickness` outside every shape,
+/// moving along the shape normal (the face normal for meshes, so mesh
+/// winding must be counter-clockwise seen from outside). Cloth::handleColliders()
+/// also applies positional friction from the contact normal.
+///
+/// Moving a shape between steps is fine: write the fields (or call
+/// setVertices()) from the thread that steps the cloth, e.g. through
+/// SimulationThread::post().
+
+struct SphereCollider
+{
+    glm::vec3 center;
+    float     radius;
+};
+
+struct CapsuleCollider
+{
+    glm::vec3 a, b;    ///< Segment end points
+    float     radius;
+};
+
+struct PlaneCollider
+{
+    glm::vec3 normal;  ///< Unit normal pointing out of the solid side
+    float     offset;  ///< Plane is dot(normal, x) = offset
+};
+
+class MeshCollider
+{
+public:
+    /// @param vertices  Mesh vertices (world space)
+    /// @param triangles Three vertex indices per triangle, CCW from outside
+    MeshCollider(std::vector<glm::vec3> vertices, std::vector<glm::ivec3> triangles);
+
+    /// Move the vertices of an animated mesh (same count and topology).
+    /// Refits the BVH and recomputes face normals, both O(triangles).
+    void setVertices(const std::vector<glm::vec3>& vertices);
+
+    /// Rebuild the BVH from scratch, e.g. after a large deformation made
+    /// the refit tree slow to query.
+    void rebuild();
+
+    /// Closest surface point to p within maxDist, and the face normal there.
+    bool closestPoint(const glm::vec3& p, float maxDist, glm::vec3& point, glm::vec3& normal) const;
+
+    const std::vector<glm::vec3>&  getVertices()  const { return vertices; }
+    const std::vector<glm::ivec3>& getTriangles() const { return triangles; }
+    const std::vector<glm::vec3>&  getFaceNormals() const { return faceNormals; }
+    const TriangleBvh&             getBvh()       const { return bvh; }
+
+    /// Bumped by every setVertices(), so users can tell the mesh moved.
+    unsigned getVersion() const { return version; }
+
+private:
+    void updateFaceNormals();
+
+    std::vector<glm::vec3>  vertices;
+    std::vector<glm::ivec3> triangles;
+    std::vector<glm::vec3>  faceNormals;
+    TriangleBvh             bvh;
+    unsigned                version = 0;
+};
+
+/// All colliders acting on one cloth. Fields are public like the Cloth
+/// parameters; meshes are shared so one character can collide with
+/// several cloths.
+class ColliderSet
+{
+public:
+    std::vector<SphereCollider>                spheres;
+    std::vector<CapsuleCollider>               capsules;
+    std::vector<PlaneCollider>                 planes;
+    std::vector<std::shared_ptr<MeshCollider>> meshes;
+
+    bool empty() const { return spheres.empty() && capsules.empty() && planes.empty() && meshes.empty(); }
+    void clear();
+
+    /// Push x to at least `thickness` outside every collider, in the order
+    /// planes, spheres, capsules, meshes. `prev` is the particle's position
+    /// at the start of the step: |x - prev| bounds how deep it can have
+    /// gone into a mesh, which sets the mesh search radius.
+    /// @param normal Set to the normal of the last contact
+    /// @return true if x was moved
+    bool resolve(glm::vec3& x, const glm::vec3& prev, float thickness, glm::vec3& normal) const;
+};
+
+/// Read the `v` and `f` lines of a Wavefront OBJ as a collider mesh.
+/// Polygons are fan-triangulated; texture/normal indices are ignored.
+/// @return false (and prints to std::cerr) if the file cannot be read
+bool readObjMesh(const std::string& path, std::vector<glm::vec3>& vertices,
+                 std::vector<glm::ivec3>& triangles);
@@ -13,6 +13,19 @@ constexpr int   CLOTH_ROWS    = 50;
 constexpr int   CLOTH_COLS    = 50;
 constexpr float CLOTH_SPACING = 0.1f;
 
+// Extra small cloths the viewer can add behind the main one (ClothWorld)
+constexpr int   FLAG_ROWS     = 12;
+constexpr int   FLAG_COLS     = 18;
+constexpr float FLAG_SPACING  = 0.06f;
+constexpr int   MAX_FLAGS     = 32;
+constexpr int   FLAGS_PER_ROW = 8;
+
+// ── Level of detail (Cloth::setLodLevel, ClothLod) ───────────────────────────
+constexpr int   LOD_MAX_LEVEL       = 3;     // Each level halves the simulated columns
+constexpr int   LOD_MIN_SEGMENTS    = 4;     // Coarsest grid: at least this many cells across
+constexpr float LOD_PIXELS_PER_CELL = 12.f;  // Viewer: target on-screen width of a simulated cell
+constexpr float LOD_HYSTERESIS      = 1.25f; // Viewer: margin before switching back
+
 // ── Physics defaults ─────────────────────────────────────────────────────────
 constexpr float DEFAULT_DELTA_TIME       = 1.f / 60.f;
 constexpr float DEFAULT_SPRING_STIFFNESS = 500.f;
@@ -23,6 +36,15 @@ constexpr float DEFAULT_PARTICLE_MASS    = 1.f;
 constexpr float DEFAULT_MAX_STRETCH      = 1.10f;
 constexpr float DEFAULT_MAX_COMPRESS     = 0.90f;
 constexpr int   DEFAULT_CONSTRAINT_ITERS = 8;
+constexpr float DEFAULT_CONSTRAINT_TOLERANCE = 1e-3f;
+constexpr int   DEFAULT_XPBD_SUBSTEPS    = 8;
+constexpr float DEFAULT_IMPLICIT_TOLERANCE = 1e-3f;
+constexpr int   DEFAULT_IMPLICIT_MAX_ITERS = 50;
+constexpr float DEFAULT_COLLISION_THICKNESS = 0.01f;
+constexpr float DEFAULT_COLLISION_FRICTION  = 0.3f;
+constexpr int   DEFAULT_CCD_ITERATIONS      = 4;
+constexpr float DEFAULT_SLEEP_SPEED         = 0.01f;
+constexpr int   DEFAULT_SLEEP_STEPS         = 30;
 constexpr glm::vec3 DEFAULT_GRAVITY      = {0.0f, -9.8f, 0.0f};
 constexpr float DEFAULT_WIND_STRENGTH    = 1.f;
 constexpr glm::vec3 DEFAULT_WIND_DIRECTION = {0.f, 0.f, 1.f};
@@ -39,3 +61,5 @@ inline const glm::vec3 DEFAULT_CAMERA_TARGET = { 0.f,  1.0f, 0.f };
 inline const glm::vec3 DEFAULT_CAMERA_UP     = { 0.f,  1.0f, 0.f };
 inline const glm::vec3 DEFAULT_LIGHT_POS     = { 3.f,  3.f,  3.f };
 inline const glm::vec3 DEFAULT_CLOTH_COLOR   = { 0.7f, 0.5f, 0.9f };
+inline const glm::vec3 PARTICLE_COLOR        = { 1.f,  1.f,  1.f  };
+inline const glm::vec3 PINNED_PARTICLE_COLOR = { 1.f,  0.2f, 0.2f };
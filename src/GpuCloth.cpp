@@ -0,0 +1,383 @@
+#include "GpuCloth.h"
+#include "ClothRenderer.h"
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// GL 4.3 compute entry points and enums are not part of the 3.3 core
+// loader, so they are fetched by hand (see ClothRenderer's bufferStorage()).
+#ifndef GL_SHADER_STORAGE_BUFFER
+#define GL_SHADER_STORAGE_BUFFER          0x90D2
+#endif
+#ifndef GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT
+#define GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT 0x00000001
+#endif
+#ifndef GL_TEXTURE_FETCH_BARRIER_BIT
+#define GL_TEXTURE_FETCH_BARRIER_BIT      0x00000008
+#endif
+#ifndef GL_SHADER_STORAGE_BARRIER_BIT
+#define GL_SHADER_STORAGE_BARRIER_BIT     0x00002000
+#endif
+
+namespace
+{
+    typedef void (APIENTRYP DispatchComputeProc)(GLuint x, GLuint y, GLuint z);
+    typedef void (APIENTRYP MemoryBarrierProc)(GLbitfield barriers);
+
+    struct ComputeProcs
+    {
+        DispatchComputeProc dispatchCompute = nullptr;
+        MemoryBarrierProc   memoryBarrier   = nullptr;
+    };
+
+    const ComputeProcs& computeProcs()
+    {
+        static ComputeProcs procs = []() {
+            ComputeProcs p;
+            GLint major = 0, minor = 0;
+            glGetIntegerv(GL_MAJOR_VERSION, &major);
+            glGetIntegerv(GL_MINOR_VERSION, &minor);
+            const bool core43 = major > 4 || (major == 4 && minor >= 3);
+            if (!core43 && !(glfwExtensionSupported("GL_ARB_compute_shader") &&
+                             glfwExtensionSupported("GL_ARB_shader_storage_buffer_object")))
+                return p;
+            p.dispatchCompute = (DispatchComputeProc)glfwGetProcAddress("glDispatchCompute");
+            p.memoryBarrier   = (MemoryBarrierProc)glfwGetProcAddress("glMemoryBarrier");
+            return p;
+        }();
+        return procs;
+    }
+
+    /// One entry of the per-particle adjacency, matches Neighbor in clothStep.comp
+    struct Neighbor
+    {
+        GLint   other;
+        GLint   type;
+        GLfloat rest;
+        GLfloat pad;
+    };
+
+    /// Matches Constraint in clothConstraints.comp
+    struct Constraint
+    {
+        GLint   a, b;
+        GLfloat rest;
+        GLfloat pad;
+    };
+
+    const int FLOATS_PER_VERTEX = 4;   ///< vec4 positions, w = invMass
+    const int INTS_PER_GRID     = 3;   ///< Attribute 1: first vertex, rows, cols
+
+    /// Texture unit the mesh shaders read positions from (as ClothRenderer)
+    const int POSITION_TEXTURE_UNIT = 0;
+
+    GLuint createStorage(GLsizeiptr bytes, const void* data)
+    {
+        GLuint buf = 0;
+        glGenBuffers(1, &buf);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buf);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, std::max<GLsizeiptr>(bytes, 16), data, GL_DYNAMIC_COPY);
+        return buf;
+    }
+
+    template <typename T>
+    GLuint createStorage(const std::vector<T>& data)
+    {
+        return createStorage((GLsizeiptr)(data.size() * sizeof(T)), data.empty() ? nullptr : data.data());
+    }
+
+    void uniform4fv(const Shader& shader, const char* name, const std::vector<glm::vec4>& v)
+    {
+        if (!v.empty())
+            glUniform4fv(shader.uniformLocation(name), (GLsizei)v.size(), &v[0].x);
+    }
+}
+
+// MARK: Construction
+bool GpuCloth::supported()
+{
+    const ComputeProcs& p = computeProcs();
+    return p.dispatchCompute && p.memoryBarrier;
+}
+
+GpuCloth::GpuCloth(const Cloth& cloth)
+    : stepShader("clothStep.comp")
+    , constraintShader("clothConstraints.comp")
+    , collideShader("clothCollide.comp")
+    , rows(cloth.getRows())
+    , cols(cloth.getCols())
+    , count(cloth.getRows() * cloth.getCols())
+    , springCount((int)cloth.getSprings().size())
+    , batches(cloth.getSpringBatches())
+{
+    // Everything on the GPU is in grid order; the CPU store may be tiled
+    const ParticleSoA&      store      = cloth.getParticleData();
+    const std::vector<int>& gridToSlot = cloth.getGridToSlot();
+    std::vector<int> slotToGrid(count);
+    for (int g = 0; g < count; ++g)
+        slotToGrid[gridToSlot[g]] = g;
+
+    std::vector<glm::vec4> pos(count), prev(count), vel(count);
+    std::vector<float>     mass(count);
+    for (int g = 0; g < count; ++g)
+    {
+        const int s = gridToSlot[g];
+        pos[g]  = glm::vec4(store.position(s), store.invMass[s]);
+        prev[g] = glm::vec4(store.previous(s), store.invMass[s]);
+        vel[g]  = glm::vec4(store.velocity(s), 0.f);
+        mass[g] = store.mass[s];
+    }
+
+    // Springs keep the CPU's batch order; the adjacency lists every spring
+    // at both of its ends, in spring order, so each particle sums its forces
+    // in the same order on every run
+    std::vector<Constraint> constraints;
+    std::vector<GLint>      adjStart(count + 1, 0);
+    constraints.reserve(springCount);
+    for (const Spring& sp : cloth.getSprings())
+    {
+        const int a = slotToGrid[sp.a], b = slotToGrid[sp.b];
+        constraints.push_back({ a, b, sp.restLength, 0.f });
+        ++adjStart[a + 1];
+        ++adjStart[b + 1];
+    }
+    for (int g = 0; g < count; ++g)
+        adjStart[g + 1] += adjStart[g];
+
+    std::vector<Neighbor> adj(adjStart[count]);
+    std::vector<GLint>    fill(adjStart.begin(), adjStart.end() - 1);
+    for (const Spring& sp : cloth.getSprings())
+    {
+        const int a = slotToGrid[sp.a], b = slotToGrid[sp.b];
+        adj[fill[a]++] = { b, (GLint)sp.type, sp.restLength, 0.f };
+        adj[fill[b]++] = { a, (GLint)sp.type, sp.restLength, 0.f };
+    }
+
+    positionBuf[0] = createStorage(pos);
+    positionBuf[1] = createStorage(prev);
+    velocityBuf[0] = createStorage(vel);
+    velocityBuf[1] = createStorage(vel);
+    massBuf        = createStorage(mass);
+    adjStartBuf    = createStorage(adjStart);
+    adjBuf         = createStorage(adj);
+    springBuf      = createStorage(constraints);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    createDrawState(cloth);
+    setParams(cloth.getParams());
+    setColliders(cloth.colliders);
+    globalTime = cloth.globalTime;
+
+    if (valid())
+        std::cout << "✓ GPU cloth: " << count << " particles, " << springCount << " springs, "
+                  << batches.size() << " batches\n";
+}
+
+void GpuCloth::createDrawState(const Cloth& cloth)
+{
+    // Attribute 1 is the same grid for every vertex: one cloth at vertex 0
+    std::vector<GLint> gridData;
+    gridData.reserve((size_t)count * INTS_PER_GRID);
+    for (int v = 0; v < count; ++v) {
+        gridData.push_back(0);
+        gridData.push_back(rows);
+        gridData.push_back(cols);
+    }
+    std::vector<unsigned int> indices;
+    ClothRenderer::appendGridIndices(rows, cols, indices);
+    indexCount = (int)indices.size();
+
+    // Pinned particles have invMass 0 and never move, so their flags are static
+    std::vector<GLfloat> pinFlags(count, 0.f);
+    const ParticleSoA& store = cloth.getParticleData();
+    for (int g = 0; g < count; ++g) {
+        if (!store.pinned(cloth.getGridToSlot()[g])) continue;
+        pinFlags[g] = 1.f;
+        ++pinnedCount;
+    }
+
+    glGenBuffers(1, &gridVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, gridVBO);
+    glBufferData(GL_ARRAY_BUFFER, gridData.size() * sizeof(GLint), gridData.data(), GL_STATIC_DRAW);
+    glGenBuffers(1, &pinVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, pinVBO);
+    glBufferData(GL_ARRAY_BUFFER, pinFlags.size() * sizeof(GLfloat), pinFlags.data(), GL_STATIC_DRAW);
+    glGenBuffers(1, &meshEBO);
+
+    // One VAO and one texture view per position buffer, so drawing after a
+    // swap only changes which pair is bound
+    glGenVertexArrays(2, meshVAO);
+    glGenTextures(2, positionTex);
+    for (int k = 0; k < 2; ++k) {
+        glBindVertexArray(meshVAO[k]);
+        glBindBuffer(GL_ARRAY_BUFFER, positionBuf[k]);
+        // Attribute 0: position (xyz of the vec4, stride=16, offset=0)
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, FLOATS_PER_VERTEX * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, gridVBO);
+        glVertexAttribIPointer(1, INTS_PER_GRID, GL_INT, INTS_PER_GRID * sizeof(GLint), (void*)0);
+        glEnableVertexAttribArray(1);
+        // Attribute 2: pinned flag for cloth.vert (1 float, stride=4)
+        glBindBuffer(GL_ARRAY_BUFFER, pinVBO);
+        glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(GLfloat), (void*)0);
+        glEnableVertexAttribArray(2);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, meshEBO);
+        if (k == 0)
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+
+        glBindTexture(GL_TEXTURE_BUFFER, positionTex[k]);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_R32F, positionBuf[k]);
+    }
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+GpuCloth::~GpuCloth()
+{
+    glDeleteBuffers(2, positionBuf);
+    glDeleteBuffers(2, velocityBuf);
+    for (GLuint buf : { massBuf, adjStartBuf, adjBuf, springBuf, gridVBO, meshEBO, pinVBO })
+        glDeleteBuffers(1, &buf);
+    glDeleteVertexArrays(2, meshVAO);
+    glDeleteTextures(2, positionTex);
+}
+
+// MARK: Parameters
+void GpuCloth::setParams(const ClothParams& p)
+{
+    params = p;
+}
+
+void GpuCloth::setColliders(const ColliderSet& set)
+{
+    // Packed here rather than per step: shapes change far less often
+    planeData.clear();
+    sphereData.clear();
+    capsuleAData.clear();
+    capsuleBData.clear();
+    for (size_t k = 0; k < std::min<size_t>(set.planes.size(), MAX_SHAPES); ++k)
+        planeData.push_back(glm::vec4(set.planes[k].normal, set.planes[k].offset));
+    for (size_t k = 0; k < std::min<size_t>(set.spheres.size(), MAX_SHAPES); ++k)
+        sphereData.push_back(glm::vec4(set.spheres[k].center, set.spheres[k].radius));
+    for (size_t k = 0; k < std::min<size_t>(set.capsules.size(), MAX_SHAPES); ++k) {
+        capsuleAData.push_back(glm::vec4(set.capsules[k].a, set.capsules[k].radius));
+        capsuleBData.push_back(glm::vec4(set.capsules[k].b, 0.f));
+    }
+    if (!set.meshes.empty() || set.planes.size() > MAX_SHAPES ||
+        set.spheres.size() > MAX_SHAPES || set.capsules.size() > MAX_SHAPES)
+        std::cerr << "✗ GPU cloth: mesh colliders and shapes beyond " << MAX_SHAPES
+                  << " per kind are ignored\n";
+}
+
+// MARK: Update
+void GpuCloth::dispatch(int invocations)
+{
+    if (invocations <= 0) return;
+    computeProcs().dispatchCompute((GLuint)((invocations + GROUP_SIZE - 1) / GROUP_SIZE), 1, 1);
+}
+
+void GpuCloth::update(float dt)
+{
+    if (!valid() || count == 0 || dt <= 0.f) return;
+    const ComputeProcs& gl = computeProcs();
+
+    globalTime += dt;
+    glm::vec3 accel = params.gravity;   // See Cloth::externalAcceleration()
+    if (params.windEnabled)
+        accel += params.windDirection * (params.windStrength * std::sin(globalTime * 2.f));
+    const float velScale = lastStep > 0.f ? dt / lastStep : 1.f;
+    lastStep = dt;
+
+    const int next = 1 - current;
+
+    // ── Forces + Verlet: x(t + dt) replaces x(t - dt) ───────────────────────
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CurrentBinding,  positionBuf[current]);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PreviousBinding, positionBuf[next]);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, VelInBinding,    velocityBuf[current]);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, VelOutBinding,   velocityBuf[next]);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MassBinding,     massBuf);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, AdjStartBinding, adjStartBuf);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, AdjBinding,      adjBuf);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SpringsBinding,  springBuf);
+
+    const GLfloat stiffness[3] = { params.springStiffness, params.springStiffness, params.bendStiffness };
+    stepShader.use();
+    stepShader.setInt("uCount", count);
+    stepShader.setVec3("uAccel", accel);
+    stepShader.setFloat("uAirDamping", params.airDamping);
+    stepShader.setFloat("uSpringDamping", params.springDamping);
+    glUniform1fv(stepShader.uniformLocation("uStiffness"), 3, stiffness);
+    stepShader.setFloat("uDt", dt);
+    stepShader.setFloat("uVelScale", velScale);
+    dispatch(count);
+    gl.memoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    // The new positions are current now; the old ones are "previous"
+    current = next;
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CurrentBinding,  positionBuf[current]);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PreviousBinding, positionBuf[1 - current]);
+
+    // ── Constraints: colour batches in order, barrier between dispatches ────
+    constraintShader.use();
+    constraintShader.setFloat("uMaxStretch", params.maxStretch);
+    constraintShader.setFloat("uMaxCompress", params.maxCompress);
+    const GLint beginLoc = constraintShader.uniformLocation("uBegin");
+    const GLint endLoc   = constraintShader.uniformLocation("uEnd");
+    for (int iter = 0; iter < params.constraintIters; ++iter) {
+        for (const SpringBatch& batch : batches) {
+            glUniform1i(beginLoc, batch.begin);
+            glUniform1i(endLoc, batch.end);
+            dispatch(batch.end - batch.begin);
+            gl.memoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        }
+    }
+
+    // ── Colliders ────────────────────────────────────────────────────────────
+    if (!planeData.empty() || !sphereData.empty() || !capsuleAData.empty()) {
+        collideShader.use();
+        collideShader.setInt("uCount", count);
+        collideShader.setFloat("uThickness", params.collisionThickness);
+        collideShader.setFloat("uFriction", params.collisionFriction);
+        collideShader.setInt("uPlaneCount", (int)planeData.size());
+        collideShader.setInt("uSphereCount", (int)sphereData.size());
+        collideShader.setInt("uCapsuleCount", (int)capsuleAData.size());
+        uniform4fv(collideShader, "uPlanes", planeData);
+        uniform4fv(collideShader, "uSpheres", sphereData);
+        uniform4fv(collideShader, "uCapsuleA", capsuleAData);
+        uniform4fv(collideShader, "uCapsuleB", capsuleBData);
+        dispatch(count);
+    }
+
+    // Next step's compute reads, this frame's draws fetch and pull vertices
+    gl.memoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT |
+                     GL_TEXTURE_FETCH_BARRIER_BIT);
+    glUseProgram(0);
+}
+
+// MARK: Draw
+void GpuCloth::bindGridUniforms(const Shader& shader) const
+{
+    glActiveTexture(GL_TEXTURE0 + POSITION_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, positionTex[current]);
+    shader.setInt("uPositions", POSITION_TEXTURE_UNIT);
+    shader.setInt("uBaseVertex", 0);
+    shader.setInt("uVertexStride", FLOATS_PER_VERTEX);
+}
+
+void GpuCloth::drawMesh() const
+{
+    if (indexCount == 0) return;
+    glBindVertexArray(meshVAO[current]);
+    glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, (void*)0);
+}
+
+void GpuCloth::drawPoints() const
+{
+    if (count == 0) return;
+    glBindVertexArray(meshVAO[current]);
+    glDrawArrays(GL_POINTS, 0, count);
+}
+
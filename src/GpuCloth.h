@@ -0,0 +1,136 @@
+#pragma once
+
+#include "Cloth.h"
+#include "Shader.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+/// @file GpuCloth.h
+/// Mass-spring Cloth::update pipeline run by GL 4.3 compute shaders, with
+/// the mesh drawn straight from the simulation buffers.
+///
+/// **Pipeline (per update()):**
+/// 1. clothStep.comp — one invocation per particle: external forces, the
+///    spring forces of its incident springs (gathered from a CSR adjacency,
+///    so there are no atomics) and the Verlet step. Same expressions as
+///    ClothKernels and Cloth::springForce in SolverMode::MassSpring.
+/// 2. clothConstraints.comp — constraintIters sweeps over the colour
+///    batches (Cloth::getSpringBatches()), one dispatch per batch with a
+///    storage barrier in between, exactly like the CPU's batch order.
+/// 3. clothCollide.comp — planes, spheres and capsules with friction.
+///
+/// **Buffers (SSBOs, grid order):**
+/// Positions and velocities are double-buffered vec4s (w of a position is
+/// invMass, 0 = pinned). The step writes x(t + dt) over x(t - dt) in place;
+/// afterwards the two position buffers swap roles, the older one becoming
+/// "previous" for the next step and for friction.
+///
+/// **Zero-copy drawing:**
+/// Each position buffer also backs a VAO (attribute 0, stride 16) and an
+/// R32F texture buffer, so mesh.vert / normalWS.vert read the positions the
+/// compute pass just wrote (uVertexStride = 4). Nothing goes through the CPU.
+/// Attribute 2 is a static pinned flag per particle (pinned particles never
+/// move), so drawPoints() colours pins in the same single draw.
+///
+/// **Limits:**
+/// Only the mass-spring solver. Sleeping, CCD, self-collision and mesh
+/// colliders stay on the CPU Cloth; setColliders() takes at most
+/// MAX_SHAPES planes, spheres and capsules. Requires a current GL 4.3
+/// context (or 3.3 + ARB_compute_shader + ARB_shader_storage_buffer_object).
+class GpuCloth
+{
+public:
+    /// Shapes of each kind passed to clothCollide.comp (its MAX_SHAPES)
+    static constexpr int MAX_SHAPES = 8;
+
+    /// Invocations per work group, the local_size_x of every .comp
+    static constexpr int GROUP_SIZE = 128;
+
+    /// True if the current context can run the compute pipeline.
+    static bool supported();
+
+    /// Upload the state, springs and parameters of a cloth (which may be
+    /// discarded afterwards). Requires supported().
+    explicit GpuCloth(const Cloth& cloth);
+    ~GpuCloth();
+
+    GpuCloth(const GpuCloth&)            = delete;
+    GpuCloth& operator=(const GpuCloth&) = delete;
+
+    /// False if a compute program failed to build; update() then does nothing.
+    bool valid() const { return stepShader.ID && constraintShader.ID && collideShader.ID; }
+
+    /// Same fields as Cloth::setParams(); only the mass-spring ones are used.
+    void setParams(const ClothParams& params);
+
+    /// Planes, spheres and capsules of colliders (meshes are ignored).
+    void setColliders(const ColliderSet& colliders);
+
+    /// One mass-spring Cloth::update(dt) on the GPU. Asynchronous: returns
+    /// once the dispatches are queued.
+    void update(float dt);
+
+    /// Bind the current positions as uPositions and set uBaseVertex and
+    /// uVertexStride (see ClothRenderer::bindGridUniforms()).
+    void bindGridUniforms(const Shader& shader) const;
+
+    void drawMesh() const;
+    /// Every particle in one draw, attribute 2 = 1 for pinned ones.
+    void drawPoints() const;
+
+    int getRows()          const { return rows; }
+    int getCols()          const { return cols; }
+    int getParticleCount() const { return count; }
+    int getSpringCount()   const { return springCount; }
+    int getPinnedCount()   const { return pinnedCount; }
+    float getSimTime()     const { return globalTime; }
+
+private:
+    /// SSBO binding points, as declared in the .comp files
+    enum Binding
+    {
+        CurrentBinding   = 0,
+        PreviousBinding  = 1,
+        VelInBinding     = 2,
+        VelOutBinding    = 3,
+        MassBinding      = 4,
+        AdjStartBinding  = 5,
+        AdjBinding       = 6,
+        SpringsBinding   = 7
+    };
+
+    void createDrawState(const Cloth& cloth);
+    static void dispatch(int invocations);
+
+    Shader stepShader;
+    Shader constraintShader;
+    Shader collideShader;
+
+    int rows = 0, cols = 0, count = 0;
+    int springCount = 0;
+    int pinnedCount = 0;
+
+    GLuint positionBuf[2] = {};    ///< vec4 per particle, see **Buffers**
+    GLuint velocityBuf[2] = {};
+    GLuint massBuf        = 0;
+    GLuint adjStartBuf    = 0;     ///< count + 1 offsets into adjBuf
+    GLuint adjBuf         = 0;     ///< Incident springs per particle
+    GLuint springBuf      = 0;     ///< Springs in colour-batch order
+    int    current        = 0;     ///< Index of x(t) in positionBuf / v(t) in velocityBuf
+
+    std::vector<SpringBatch> batches;
+
+    GLuint meshVAO[2]     = {};    ///< One per position buffer
+    GLuint positionTex[2] = {};    ///< R32F views of positionBuf
+    GLuint gridVBO = 0, meshEBO = 0;
+    GLuint pinVBO = 0;             ///< Attribute 2: pinned flag per particle
+    int    indexCount = 0;
+
+    ClothParams params;
+    /// Shapes as collide.comp uniforms, packed by setColliders() (meshes dropped)
+    std::vector<glm::vec4> planeData, sphereData, capsuleAData, capsuleBData;
+    float globalTime = 0.f;
+    float lastStep   = 0.f;        ///< See Cloth::matchStepLength()
+};
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "Profiler.h"
+
+#include <glad/glad.h>
+
+/// @file GpuTimer.h
+/// GL_TIME_ELAPSED queries around the viewer's draw and compute passes,
+/// reported to the Profiler as GPU zones.
+///
+/// **Latency:**
+/// Each frame's queries are read back LATENCY frames later, once the GPU
+/// has long finished them, so timing never stalls the pipeline. A result
+/// that is still not available then is dropped rather than waited for.
+///
+/// **Nesting:**
+/// GL allows one GL_TIME_ELAPSED query at a time, so GPU scopes must not
+/// nest; an inner begin() is ignored.
+///
+/// Like PROFILE_SCOPE, GPU_PROFILE_SCOPE compiles to nothing without
+/// CLOTHSIM_PROFILING and skips the queries while the Profiler is disabled.
+class GpuTimer
+{
+public:
+    static constexpr int LATENCY     = 4;    ///< Frames before a result is read
+    static constexpr int MAX_QUERIES = 16;   ///< Timed ranges per frame
+
+    GpuTimer() = default;   ///< Needs a current GL context from the first begin() on
+    ~GpuTimer()
+    {
+        if (!created) return;
+        for (Frame& f : frames)
+            for (Query& q : f.queries)
+                glDeleteQueries(1, &q.id);
+    }
+
+    GpuTimer(const GpuTimer&)            = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+    /// Start timing zone (a Profiler::zone() id)
+    void begin(int zone)
+    {
+        Frame& f = frames[current];
+        if (!Profiler::enabled() || running || f.count == MAX_QUERIES) return;
+        if (!created) create();
+        Query& q = f.queries[f.count++];
+        q.zone   = zone;
+        q.cpuNs  = Profiler::nowNs();
+        glBeginQuery(GL_TIME_ELAPSED, q.id);
+        running = true;
+    }
+
+    void end()
+    {
+        if (!running) return;
+        glEndQuery(GL_TIME_ELAPSED);
+        running = false;
+    }
+
+    /// Once per frame, after the last end(): hand the results of the frame
+    /// LATENCY - 1 frames back to the Profiler and reuse its queries.
+    void endFrame()
+    {
+        current = (current + 1) % LATENCY;
+        Frame& f = frames[current];
+        for (int i = 0; i < f.count; ++i)
+        {
+            GLint available = 0;
+            glGetQueryObjectiv(f.queries[i].id, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) continue;
+            GLuint64 ns = 0;
+            glGetQueryObjectui64v(f.queries[i].id, GL_QUERY_RESULT, &ns);
+            Profiler::addGpuSample(f.queries[i].zone, f.queries[i].cpuNs, ns * 1e-6);
+        }
+        f.count = 0;
+    }
+
+    /// Times the rest of the enclosing block on the GPU
+    class Scope
+    {
+    public:
+        Scope(GpuTimer& timer, int zone) : timer(timer) { timer.begin(zone); }
+        ~Scope() { timer.end(); }
+
+        Scope(const Scope&)            = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        GpuTimer& timer;
+    };
+
+private:
+    struct Query
+    {
+        GLuint  id    = 0;
+        int     zone  = -1;
+        int64_t cpuNs = 0;   ///< When the query began, for the trace
+    };
+
+    struct Frame
+    {
+        Query queries[MAX_QUERIES];
+        int   count = 0;
+    };
+
+    void create()
+    {
+        for (Frame& f : frames)
+            for (Query& q : f.queries)
+                glGenQueries(1, &q.id);
+        created = true;
+    }
+
+    Frame frames[LATENCY];
+    int   current = 0;
+    bool  running = false;
+    bool  created = false;
+};
+
+#if CLOTHSIM_PROFILING
+/// Time the rest of the enclosing block on the GPU as zone name (a string literal)
+#define GPU_PROFILE_SCOPE(timer, name)                                                        \
+    static const int PROFILE_CONCAT(gpuProfileZone_, __LINE__) = Profiler::zone(name);       \
+    GpuTimer::Scope  PROFILE_CONCAT(gpuProfileScope_, __LINE__)(timer, PROFILE_CONCAT(gpuProfileZone_, __LINE__))
+#else
+#define GPU_PROFILE_SCOPE(timer, name) ((void)0)
+#endif
@@ -0,0 +1,194 @@
+#include "MultigridStretch.h"
+#include "Profiler.h"
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+// MARK: Levels
+void MultigridStretch::build(const ParticleSoA& store, const std::vector<int>& gridToSlot, int rows, int cols, float spacing)
+{
+    levels.clear();
+    dirty = false;
+
+    // Rows and columns holding a pin stay on every level, so the coarse
+    // solve sees each pin as a fixed node
+    std::vector<char> pinnedRow(rows, 0), pinnedCol(cols, 0);
+    for (int r = 0; r < rows; ++r)
+        for (int c = 0; c < cols; ++c)
+            if (store.invMass[gridToSlot[r * cols + c]] == 0.f)
+                pinnedRow[r] = pinnedCol[c] = 1;
+
+    // Node rows (or cols) of one axis, and for every grid row the node row
+    // at or before it plus the weight of the following one
+    auto buildAxis = [](int n, int stride, const std::vector<char>& keep, std::vector<int>& nodes,
+                        std::vector<int>& cell, std::vector<float>& t)
+    {
+        nodes.clear();
+        for (int i = 0; i < n; ++i)
+            if (i % stride == 0 || i == n - 1 || keep[i])
+                nodes.push_back(i);
+        cell.resize(n);
+        t.resize(n);
+        for (int i = 0, j = 0; i < n; ++i)
+        {
+            while (j + 2 < (int)nodes.size() && nodes[j + 1] <= i) ++j;
+            cell[i] = j;
+            t[i]    = (float)(i - nodes[j]) / (nodes[j + 1] - nodes[j]);
+        }
+    };
+
+    int prevNodes = rows * cols;
+    for (int stride = 2; (std::max(rows, cols) - 1) / stride >= 2; stride *= 2)
+    {
+        Level level;
+        buildAxis(rows, stride, pinnedRow, level.rowIdx, level.rowCell, level.rowT);
+        buildAxis(cols, stride, pinnedCol, level.colIdx, level.colCell, level.colT);
+        const int R = (int)level.rowIdx.size();
+        const int C = (int)level.colIdx.size();
+        if (R * C >= prevNodes) break;   // Pins everywhere: nothing left to coarsen
+        prevNodes = R * C;
+
+        // Eight independent batches: horizontal and vertical links by the
+        // parity of their column / row, both diagonals by the parity of their row
+        auto link = [&](int i0, int j0, int i1, int j1) -> Link {
+            const float dr = (float)(level.rowIdx[i1] - level.rowIdx[i0]);
+            const float dc = (float)(level.colIdx[j1] - level.colIdx[j0]);
+            return { i0 * C + j0, i1 * C + j1, spacing * std::sqrt(dr * dr + dc * dc) };
+        };
+        auto batch = [&](SpringType type) {
+            level.batches.push_back({ (int)level.links.size(), (int)level.links.size(), type });
+        };
+        for (int p = 0; p < 2; ++p)
+        {
+            batch(SpringType::Structural);
+            for (int i = 0; i < R; ++i)
+                for (int j = p; j + 1 < C; j += 2) level.links.push_back(link(i, j, i, j + 1));
+            level.batches.back().end = (int)level.links.size();
+        }
+        for (int p = 0; p < 2; ++p)
+        {
+            batch(SpringType::Structural);
+            for (int i = p; i + 1 < R; i += 2)
+                for (int j = 0; j < C; ++j) level.links.push_back(link(i, j, i + 1, j));
+            level.batches.back().end = (int)level.links.size();
+        }
+        for (int d = 0; d < 2; ++d)
+            for (int p = 0; p < 2; ++p)
+            {
+                batch(SpringType::Shear);
+                for (int i = p; i + 1 < R; i += 2)
+                    for (int j = 0; j + 1 < C; ++j)
+                        level.links.push_back(d == 0 ? link(i, j, i + 1, j + 1) : link(i, j + 1, i + 1, j));
+                level.batches.back().end = (int)level.links.size();
+            }
+
+        for (std::vector<float>* v : { &level.x, &level.y, &level.z, &level.dx, &level.dy, &level.dz, &level.invMass })
+            v->resize(R * C);
+        levels.push_back(std::move(level));
+    }
+}
+
+// MARK: Solve
+void MultigridStretch::solve(ParticleSoA& store, const std::vector<int>& gridToSlot, int rows, int cols,
+                             float spacing, float maxStretch, bool parallel, ThreadPool& pool)
+{
+    PROFILE_SCOPE("multigrid");
+    constexpr int minLinksPerThread = 256;
+    constexpr int minRowsPerThread  = 8;
+
+    if (dirty) build(store, gridToSlot, rows, cols, spacing);
+    auto idx = [&](int row, int col) { return gridToSlot[row * cols + col]; };
+
+    float*       px   = store.posX.data();
+    float*       py   = store.posY.data();
+    float*       pz   = store.posZ.data();
+    const float* invM = store.invMass.data();
+
+    for (int l = (int)levels.size() - 1; l >= 0; --l)
+    {
+        Level& level = levels[l];
+        const int C = (int)level.colIdx.size();
+
+        // 1. Gather the nodes (dx keeps where they started)
+        for (int i = 0; i < (int)level.rowIdx.size(); ++i)
+            for (int j = 0; j < C; ++j)
+            {
+                const int n    = i * C + j;
+                const int slot = idx(level.rowIdx[i], level.colIdx[j]);
+                level.x[n] = level.dx[n] = px[slot];
+                level.y[n] = level.dy[n] = py[slot];
+                level.z[n] = level.dz[n] = pz[slot];
+                level.invMass[n] = invM[slot];
+            }
+
+        // 2. Stretch-only sweeps over the coarse links
+        float* x = level.x.data();
+        float* y = level.y.data();
+        float* z = level.z.data();
+        const float* w = level.invMass.data();
+        auto project = [&](const Link& s)
+        {
+            const glm::vec3 delta  = { x[s.b] - x[s.a], y[s.b] - y[s.a], z[s.b] - z[s.a] };
+            const float     distSq = glm::dot(delta, delta);
+            const float     maxLen = s.restLength * maxStretch;
+            const float     wSum   = w[s.a] + w[s.b];
+            if (distSq <= maxLen * maxLen || wSum == 0.f) return;
+
+            const float     dist       = std::sqrt(distSq);
+            const glm::vec3 correction = delta * ((dist - maxLen) / (dist * wSum));
+            x[s.a] += correction.x * w[s.a];  y[s.a] += correction.y * w[s.a];  z[s.a] += correction.z * w[s.a];
+            x[s.b] -= correction.x * w[s.b];  y[s.b] -= correction.y * w[s.b];  z[s.b] -= correction.z * w[s.b];
+        };
+        for (int sweep = 0; sweep < SWEEPS; ++sweep)
+            for (const SpringBatch& batch : level.batches)
+            {
+                const Link* links = level.links.data() + batch.begin;
+                if (!parallel)
+                {
+                    for (int k = 0; k < batch.end - batch.begin; ++k) project(links[k]);
+                    continue;
+                }
+                pool.parallelFor(batch.end - batch.begin, minLinksPerThread, [&](int begin, int end)
+                {
+                    for (int k = begin; k < end; ++k) project(links[k]);
+                });
+            }
+
+        // 3. Prolongate: bilinear node displacements onto every free particle
+        bool moved = false;
+        for (int n = 0; n < (int)level.x.size(); ++n)
+        {
+            level.dx[n] = level.x[n] - level.dx[n];
+            level.dy[n] = level.y[n] - level.dy[n];
+            level.dz[n] = level.z[n] - level.dz[n];
+            moved |= level.dx[n] != 0.f || level.dy[n] != 0.f || level.dz[n] != 0.f;
+        }
+        if (!moved) continue;
+        pool.parallelFor(rows, minRowsPerThread, [&](int rowBegin, int rowEnd)
+        {
+            const float* dx = level.dx.data();
+            const float* dy = level.dy.data();
+            const float* dz = level.dz.data();
+            for (int r = rowBegin; r < rowEnd; ++r)
+            {
+                const int   top = level.rowCell[r] * C;
+                const float t   = level.rowT[r];
+                for (int c = 0; c < cols; ++c)
+                {
+                    const int slot = idx(r, c);
+                    if (invM[slot] == 0.f) continue;
+                    const int   n00 = top + level.colCell[c];
+                    const int   n10 = n00 + C;
+                    const float u   = level.colT[c];
+                    const float w00 = (1.f - t) * (1.f - u), w01 = (1.f - t) * u;
+                    const float w10 = t * (1.f - u),         w11 = t * u;
+                    px[slot] += w00 * dx[n00] + w01 * dx[n00 + 1] + w10 * dx[n10] + w11 * dx[n10 + 1];
+                    py[slot] += w00 * dy[n00] + w01 * dy[n00 + 1] + w10 * dy[n10] + w11 * dy[n10 + 1];
+                    pz[slot] += w00 * dz[n00] + w01 * dz[n00 + 1] + w10 * dz[n10] + w11 * dz[n10 + 1];
+                }
+            }
+        });
+    }
+}
@@ -17,7 +17,8 @@
 /// - pinned: if true, position is fixed (immovable anchor point)
 ///
 /// **Usage:**
-/// Particles are stored in a flat 1D array in Cloth::particles.
+/// The simulation itself stores particles structure-of-arrays (ParticleSoA).
+/// This struct is the AoS view returned by Cloth::getParticles(), a flat 1D array.
 /// Access as: particles[row * cols + col] for grid(row, col)
 ///
 /// **Verlet Integration:**
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "AlignedAllocator.h"
+
+#include <glm/glm.hpp>
+#include <vector>
+
+/// @file ParticleSoA.h
+/// Structure-of-arrays particle storage used by the Cloth hot loops.
+///
+/// **Why SoA?**
+/// The AoS `Particle` struct is ~52 bytes, but each phase only touches a few
+/// fields: integrate() reads position/prev/force/invMass, satisfyConstraints()
+/// only positions and invMass. With one array per component every cache line
+/// fetched is fully used, and the loops become straight streams of floats that
+/// the compiler can auto-vectorize.
+///
+/// **Layout:**
+/// - posX/Y/Z   current position (meters)
+/// - prevX/Y/Z  previous position (Verlet state)
+/// - velX/Y/Z   velocity recovered by integrate() (m/s)
+/// - forceX/Y/Z accumulated force this step
+/// - mass       particle mass (kg), kept so unpinning can restore invMass
+/// - invMass    1 / mass, or 0 for pinned particles
+///
+/// Pinned particles are encoded as invMass == 0: every phase weights its
+/// update by invMass (or a mask derived from it), so no per-particle branch.
+///
+/// All arrays are 64-byte aligned and indexed by store slot; Cloth picks
+/// the slot of grid(row, col) from its ParticleLayout (Cloth::particleIndex).
+using AlignedFloats = std::vector<float, AlignedAllocator<float, 64>>;
+
+struct ParticleSoA
+{
+    AlignedFloats posX,   posY,   posZ;
+    AlignedFloats prevX,  prevY,  prevZ;
+    AlignedFloats velX,   velY,   velZ;
+    AlignedFloats forceX, forceY, forceZ;
+    AlignedFloats mass;
+    AlignedFloats invMass;
+
+    int size() const { return (int)posX.size(); }
+
+    /// Resize every array to n particles (new entries zeroed).
+    void resize(int n)
+    {
+        for (AlignedFloats* a : { &posX, &posY, &posZ, &prevX, &prevY, &prevZ,
+                                  &velX, &velY, &velZ, &forceX, &forceY, &forceZ,
+                                  &mass, &invMass })
+            a->assign(n, 0.f);
+    }
+
+    bool pinned(int i) const { return invMass[i] == 0.f; }
+
+    glm::vec3 position(int i) const { return { posX[i],  posY[i],  posZ[i]  }; }
+    glm::vec3 previous(int i) const { return { prevX[i], prevY[i], prevZ[i] }; }
+    glm::vec3 velocity(int i) const { return { velX[i],  velY[i],  velZ[i]  }; }
+    glm::vec3 force(int i)    const { return { forceX[i], forceY[i], forceZ[i] }; }
+
+    void setPosition(int i, const glm::vec3& p) { posX[i]  = p.x; posY[i]  = p.y; posZ[i]  = p.z; }
+    void setPrevious(int i, const glm::vec3& p) { prevX[i] = p.x; prevY[i] = p.y; prevZ[i] = p.z; }
+    void setVelocity(int i, const glm::vec3& v) { velX[i]  = v.x; velY[i]  = v.y; velZ[i]  = v.z; }
+};
@@ -0,0 +1,304 @@
+#include "Profiler.h"
+
+#if CLOTHSIM_PROFILING
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Profiler
+{
+namespace detail
+{
+    std::atomic<bool> enabledFlag{ false };
+}
+
+namespace
+{
+    struct Event
+    {
+        int     zone;
+        int64_t begin, end;   ///< nowNs()
+    };
+
+    /// Trace events of one thread. Only that thread appends; the mutex is
+    /// uncontended except while a trace is written or cleared.
+    struct Track
+    {
+        std::mutex         mutex;
+        std::vector<Event> events;
+        std::string        name;
+        int                tid = 0;
+    };
+
+    struct State
+    {
+        std::mutex           registryMutex;   ///< Zone names and the track list
+        std::atomic<int>     zoneCount{ 0 };
+        const char*          names[MAX_ZONES] = {};
+        std::atomic<bool>    gpu[MAX_ZONES]     = {};
+        std::atomic<int64_t> totalNs[MAX_ZONES] = {};   ///< Current frame
+
+        // endFrame() thread only
+        float   history[MAX_ZONES][HISTORY] = {};
+        int     historyOffset = 0;   ///< Next slot written, i.e. the oldest
+        int64_t lastFrameNs   = 0;
+
+        std::vector<std::unique_ptr<Track>> tracks;   ///< Never shrinks: threads keep raw pointers
+        Track                gpuTrack;
+        std::atomic<bool>    tracing{ false };
+        std::string          tracePath;
+        int                  traceFramesLeft = 0;
+        int64_t              traceStartNs    = 0;
+        std::vector<int64_t> frameMarks;
+    };
+
+    // Leaked on purpose: pool workers may still end scopes during static destruction
+    State& state()
+    {
+        static State* s = new State;
+        return *s;
+    }
+
+    thread_local Track* threadTrack = nullptr;
+
+    Track& currentTrack()
+    {
+        if (!threadTrack)
+        {
+            State& s = state();
+            std::lock_guard<std::mutex> lock(s.registryMutex);
+            s.tracks.push_back(std::make_unique<Track>());
+            threadTrack       = s.tracks.back().get();
+            threadTrack->tid  = (int)s.tracks.size();
+            threadTrack->name = "thread " + std::to_string(threadTrack->tid);
+        }
+        return *threadTrack;
+    }
+
+    void writeEvents(std::FILE* f, const std::vector<Event>& events, int tid, int64_t start, bool& first)
+    {
+        const State& s = state();
+        for (const Event& e : events)
+        {
+            if (e.begin < start) continue;   // GPU results of frames issued before the trace began
+            std::fprintf(f, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                         first ? "" : ",", s.names[e.zone], tid,
+                         (e.begin - start) * 1e-3, (e.end - e.begin) * 1e-3);
+            first = false;
+        }
+    }
+}
+
+void setEnabled(bool enabled)
+{
+    detail::enabledFlag.store(enabled, std::memory_order_relaxed);
+}
+
+int64_t nowNs()
+{
+    using clock = std::chrono::steady_clock;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now().time_since_epoch()).count();
+}
+
+int zone(const char* name)
+{
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.registryMutex);
+    const int n = s.zoneCount.load();
+    for (int z = 0; z < n; ++z)
+        if (std::strcmp(s.names[z], name) == 0) return z;
+    if (n == MAX_ZONES) return -1;
+    s.names[n] = name;
+    s.zoneCount.store(n + 1);
+    return n;
+}
+
+void record(int zone, int64_t beginNs, int64_t endNs)
+{
+    if (zone < 0) return;
+    State& s = state();
+    s.totalNs[zone].fetch_add(endNs - beginNs, std::memory_order_relaxed);
+    if (s.tracing.load(std::memory_order_relaxed))
+    {
+        Track& track = currentTrack();
+        std::lock_guard<std::mutex> lock(track.mutex);
+        track.events.push_back({ zone, beginNs, endNs });
+    }
+}
+
+void addGpuSample(int zone, int64_t cpuBeginNs, double ms)
+{
+    if (zone < 0) return;
+    State& s = state();
+    const int64_t ns = (int64_t)(ms * 1e6);
+    s.gpu[zone].store(true, std::memory_order_relaxed);
+    s.totalNs[zone].fetch_add(ns, std::memory_order_relaxed);
+    if (s.tracing.load(std::memory_order_relaxed))
+    {
+        std::lock_guard<std::mutex> lock(s.gpuTrack.mutex);
+        s.gpuTrack.events.push_back({ zone, cpuBeginNs, cpuBeginNs + ns });
+    }
+}
+
+void setThreadName(const char* name)
+{
+    Track& track = currentTrack();
+    std::lock_guard<std::mutex> lock(state().registryMutex);
+    track.name = name;
+}
+
+// MARK: Frames
+void endFrame()
+{
+    State& s = state();
+    static const int frameZone = zone("frame");
+
+    const int64_t now = nowNs();
+    const int64_t frameNs = s.lastFrameNs ? now - s.lastFrameNs : 0;
+    s.lastFrameNs = now;
+    if (!enabled()) return;
+
+    s.totalNs[frameZone].fetch_add(frameNs, std::memory_order_relaxed);
+    const int n = s.zoneCount.load();
+    for (int z = 0; z < n; ++z)
+        s.history[z][s.historyOffset] = s.totalNs[z].exchange(0, std::memory_order_relaxed) * 1e-6f;
+    s.historyOffset = (s.historyOffset + 1) % HISTORY;
+
+    if (s.tracing.load())
+    {
+        s.frameMarks.push_back(now);
+        if (--s.traceFramesLeft <= 0) endTrace();
+    }
+}
+
+// MARK: Trace
+bool beginTrace(const std::string& path, int frames)
+{
+    State& s = state();
+    if (s.tracing.load()) return false;
+    {
+        std::lock_guard<std::mutex> lock(s.registryMutex);
+        for (const auto& track : s.tracks)
+        {
+            std::lock_guard<std::mutex> trackLock(track->mutex);
+            track->events.clear();
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(s.gpuTrack.mutex);
+        s.gpuTrack.events.clear();
+    }
+    s.frameMarks.clear();
+    s.tracePath       = path;
+    s.traceFramesLeft = std::max(1, frames);
+    s.traceStartNs    = nowNs();
+    setEnabled(true);
+    s.tracing.store(true);
+    return true;
+}
+
+bool endTrace()
+{
+    State& s = state();
+    if (!s.tracing.exchange(false)) return false;
+
+    std::FILE* f = std::fopen(s.tracePath.c_str(), "w");
+    if (!f)
+    {
+        std::cerr << "✗ Cannot write trace " << s.tracePath << "\n";
+        return false;
+    }
+
+    const int64_t start = s.traceStartNs;
+    bool first = true;
+    std::fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+    std::lock_guard<std::mutex> lock(s.registryMutex);
+    const int gpuTid = (int)s.tracks.size() + 1;
+    for (const auto& track : s.tracks)
+    {
+        std::lock_guard<std::mutex> trackLock(track->mutex);
+        std::fprintf(f, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                     first ? "" : ",", track->tid, track->name.c_str());
+        first = false;
+        writeEvents(f, track->events, track->tid, start, first);
+    }
+    {
+        std::lock_guard<std::mutex> gpuLock(s.gpuTrack.mutex);
+        std::fprintf(f, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"GPU\"}}",
+                     first ? "" : ",", gpuTid);
+        first = false;
+        writeEvents(f, s.gpuTrack.events, gpuTid, start, first);
+    }
+    for (int64_t mark : s.frameMarks)
+        std::fprintf(f, ",\n{\"name\":\"frame\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":0,\"ts\":%.3f}",
+                     (mark - start) * 1e-3);
+    std::fprintf(f, "\n]}\n");
+
+    const bool ok = std::fclose(f) == 0;
+    if (ok)
+        std::cerr << "✓ Wrote trace " << s.tracePath << " (" << s.frameMarks.size() << " frames)\n";
+    else
+        std::cerr << "✗ Failed writing trace " << s.tracePath << "\n";
+    return ok;
+}
+
+bool isTracing()
+{
+    return state().tracing.load();
+}
+
+// MARK: Histories
+int getZoneCount()
+{
+    return state().zoneCount.load();
+}
+
+const char* getZoneName(int zone)
+{
+    return state().names[zone];
+}
+
+bool isGpuZone(int zone)
+{
+    return state().gpu[zone].load(std::memory_order_relaxed);
+}
+
+const float* getHistory(int zone)
+{
+    return state().history[zone];
+}
+
+int getHistoryOffset()
+{
+    return state().historyOffset;
+}
+
+float getLastMs(int zone)
+{
+    const State& s = state();
+    return s.history[zone][(s.historyOffset + HISTORY - 1) % HISTORY];
+}
+
+float getMeanMs(int zone)
+{
+    const float* h = state().history[zone];
+    float sum = 0.f;
+    for (int i = 0; i < HISTORY; ++i) sum += h[i];
+    return sum / HISTORY;
+}
+
+float getMaxMs(int zone)
+{
+    const float* h = state().history[zone];
+    return *std::max_element(h, h + HISTORY);
+}
+}
+
+#endif // CLOTHSIM_PROFILING
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/// @file Profiler.h
+/// Scoped CPU timers for the phases of Cloth::update, the simulation thread
+/// and the render loop, with rolling per-frame histories and Chrome trace
+/// capture.
+///
+/// **Zones:**
+/// PROFILE_SCOPE("name") times the rest of the enclosing block. Each name is
+/// a zone; every end of a scope adds its duration to the zone's total for
+/// the current frame, from any thread. Phases that run on several threads
+/// at once (one cloth per worker in ClothWorld) therefore sum thread time.
+/// GPU timings from GpuTimer arrive as samples of their own zones.
+///
+/// **Frames:**
+/// endFrame() closes a frame: each zone's total goes into its history ring
+/// (HISTORY frames, in ms) and is reset, and the "frame" zone records the
+/// time since the previous endFrame(). The viewer calls it once per render
+/// frame, clothsim_headless once per step; the histories belong to that
+/// thread.
+///
+/// **Trace:**
+/// beginTrace(path, frames) additionally records every scope as an event
+/// for the next frames calls of endFrame(), then writes them as Chrome trace
+/// JSON (chrome://tracing, ui.perfetto.dev): one track per thread, named by
+/// setThreadName(), plus a "GPU" track and a marker at each frame boundary.
+///
+/// **Cost:**
+/// Compiled out entirely with -DCLOTHSIM_PROFILING=OFF (PROFILE_SCOPE
+/// expands to nothing, the functions below become inline no-ops). Compiled
+/// in but disabled at run time (the default), a scope costs one relaxed
+/// atomic load; enabled, two clock reads and an atomic add.
+
+#ifndef CLOTHSIM_PROFILING
+#define CLOTHSIM_PROFILING 1
+#endif
+
+namespace Profiler
+{
+    constexpr int MAX_ZONES = 64;    ///< Further zone names are ignored
+    constexpr int HISTORY   = 240;   ///< Frames kept per zone
+
+#if CLOTHSIM_PROFILING
+    namespace detail
+    {
+        extern std::atomic<bool> enabledFlag;
+    }
+
+    /// Runtime switch; scopes record nothing while off.
+    void setEnabled(bool enabled);
+    inline bool enabled() { return detail::enabledFlag.load(std::memory_order_relaxed); }
+
+    /// Monotonic clock, nanoseconds.
+    int64_t nowNs();
+
+    /// Id of the zone called name (registered on first use; name must
+    /// outlive the program, e.g. a literal). -1 once MAX_ZONES are taken.
+    int zone(const char* name);
+
+    /// Add a scope [beginNs, endNs) of zone on the calling thread.
+    void record(int zone, int64_t beginNs, int64_t endNs);
+
+    /// Add a GPU timing of zone. It is traced on the GPU track starting at
+    /// cpuBeginNs, the CPU time its commands were issued.
+    void addGpuSample(int zone, int64_t cpuBeginNs, double ms);
+
+    /// Name the calling thread's track in traces.
+    void setThreadName(const char* name);
+
+    /// Close the current frame (see Frames above).
+    void endFrame();
+
+    /// Start recording events for the next frames frames, then write path.
+    /// @return false if a trace is already being recorded
+    bool beginTrace(const std::string& path, int frames);
+
+    /// Write the trace being recorded now instead of waiting for its frames.
+    /// @return false if no trace was recorded or the file could not be written
+    bool endTrace();
+
+    bool isTracing();
+
+    // ── Histories (endFrame() thread only) ───────────────────────────────────
+    int         getZoneCount();
+    const char* getZoneName(int zone);
+    bool        isGpuZone(int zone);       ///< Fed by addGpuSample()
+    /// HISTORY per-frame totals in ms; the oldest is at getHistoryOffset()
+    const float* getHistory(int zone);
+    int          getHistoryOffset();
+    float        getLastMs(int zone);      ///< Most recent frame
+    float        getMeanMs(int zone);      ///< Over the history
+    float        getMaxMs(int zone);       ///< Over the history
+
+    /// Times the rest of the enclosing block as zone
+    class Scope
+    {
+    public:
+        explicit Scope(int zone) : id(zone), begin(enabled() ? nowNs() : 0) {}
+        ~Scope() { if (begin) record(id, begin, nowNs()); }
+
+        Scope(const Scope&)            = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        int     id;
+        int64_t begin;   ///< 0 when disabled at construction
+    };
+#else
+    inline void        setEnabled(bool) {}
+    inline bool        enabled() { return false; }
+    inline int64_t     nowNs() { return 0; }
+    inline int         zone(const char*) { return -1; }
+    inline void        record(int, int64_t, int64_t) {}
+    inline void        addGpuSample(int, int64_t, double) {}
+    inline void        setThreadName(const char*) {}
+    inline void        endFrame() {}
+    inline bool        beginTrace(const std::string&, int) { return false; }
+    inline bool        endTrace() { return false; }
+    inline bool        isTracing() { return false; }
+    inline int         getZoneCount() { return 0; }
+    inline const char* getZoneName(int) { return ""; }
+    inline bool        isGpuZone(int) { return false; }
+    inline const float* getHistory(int) { return nullptr; }
+    inline int         getHistoryOffset() { return 0; }
+    inline float       getLastMs(int) { return 0.f; }
+    inline float       getMeanMs(int) { return 0.f; }
+    inline float       getMaxMs(int) { return 0.f; }
+#endif
+}
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b)  PROFILE_CONCAT_(a, b)
+
+#if CLOTHSIM_PROFILING
+/// Time the rest of the enclosing block as zone name (a string literal)
+#define PROFILE_SCOPE(name)                                                             \
+    static const int PROFILE_CONCAT(profileZone_, __LINE__) = Profiler::zone(name);     \
+    Profiler::Scope  PROFILE_CONCAT(profileScope_, __LINE__)(PROFILE_CONCAT(profileZone_, __LINE__))
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#endif
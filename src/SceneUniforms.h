@@ -0,0 +1,76 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+/// @file SceneUniforms.h
+/// Camera and light data shared by every viewer shader, in one uniform
+/// buffer written once per frame instead of per program and per draw.
+///
+/// **Layout:**
+/// SceneBlock mirrors `layout(std140) uniform Scene` in mesh.vert,
+/// mesh.frag, normalWS.vert and cloth.vert member for member. Only mat4
+/// and vec4 members, so std140 adds no padding and the C++ struct can be
+/// copied as is. The normal matrix is the inverse transpose of uModel,
+/// computed here once rather than per vertex.
+///
+/// **Binding:**
+/// The buffer stays bound to BINDING for its lifetime; each program links
+/// its Scene block to that point once, with Shader::bindUniformBlock().
+struct SceneBlock
+{
+    glm::mat4 mvp;
+    glm::mat4 model;
+    glm::mat4 normalMatrix;
+    glm::vec4 viewPos;    ///< xyz = camera position
+    glm::vec4 lightPos;   ///< xyz = point light position
+};
+static_assert(sizeof(SceneBlock) == 3 * 64 + 2 * 16, "SceneBlock must match the std140 Scene block");
+
+class SceneUniforms
+{
+public:
+    /// Uniform buffer binding point of the Scene block
+    static constexpr GLuint BINDING = 0;
+
+    /// Block name as declared in the shaders
+    static constexpr const char* BLOCK_NAME = "Scene";
+
+    /// Requires a current GL context.
+    SceneUniforms()
+    {
+        glGenBuffers(1, &ubo);
+        glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(SceneBlock), nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        glBindBufferBase(GL_UNIFORM_BUFFER, BINDING, ubo);
+    }
+
+    ~SceneUniforms()
+    {
+        glDeleteBuffers(1, &ubo);
+    }
+
+    SceneUniforms(const SceneUniforms&)            = delete;
+    SceneUniforms& operator=(const SceneUniforms&) = delete;
+
+    /// Fill the block from the frame's camera and light. Call once per
+    /// frame, before the first draw.
+    void update(const glm::mat4& viewProj, const glm::mat4& model,
+                const glm::vec3& viewPos, const glm::vec3& lightPos)
+    {
+        SceneBlock block;
+        block.mvp          = viewProj * model;
+        block.model        = model;
+        block.normalMatrix = glm::transpose(glm::inverse(model));
+        block.viewPos      = glm::vec4(viewPos, 1.f);
+        block.lightPos     = glm::vec4(lightPos, 1.f);
+
+        glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(SceneBlock), &block);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+private:
+    GLuint ubo = 0;
+};
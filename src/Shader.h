@@ -9,9 +9,28 @@
 #include <sstream>
 #include <iostream>
 #include <filesystem>
+#include <unordered_map>
+#include <vector>
 
 namespace fs = std::filesystem;
 
+/// @file Shader.h
+/// Header-only GLSL program wrapper: loads sources from the shader search
+/// path, compiles and links them and sets uniforms by name.
+///
+/// **Uniform locations:**
+/// Looked up once after linking (every active default-block uniform, arrays
+/// under their base name) and kept in a map, so the set*() calls of the
+/// render loop never go back to glGetUniformLocation. An unknown name maps
+/// to -1, which GL ignores, just like an inactive uniform. Members of
+/// uniform blocks have no location; bindUniformBlock() attaches a block to
+/// a buffer binding point instead (see SceneUniforms).
+
+// Compute shaders are GL 4.3; the glad loader only covers 3.3 core
+#ifndef GL_COMPUTE_SHADER
+#define GL_COMPUTE_SHADER 0x91B9
+#endif
+
 class Shader
 {
 public:
@@ -52,12 +71,45 @@ public:
 
         glDeleteShader(vertex);
         glDeleteShader(fragment);
+        cacheUniformLocations();
 
         if (ID != 0) {
             std::cout << "✓ Shader program compiled and linked successfully\n";
         }
     }
 
+    /// Compute program (needs a GL 4.3 context, see GpuCloth::supported()).
+    explicit Shader(const char* computePath)
+    {
+        std::string computeCode = readShaderFile(computePath);
+        if (computeCode.empty()) {
+            std::cerr << "Failed to load shader file\n";
+            ID = 0;
+            return;
+        }
+
+        const char* cShaderCode = computeCode.c_str();
+        unsigned int compute = glCreateShader(GL_COMPUTE_SHADER);
+        glShaderSource(compute, 1, &cShaderCode, nullptr);
+        glCompileShader(compute);
+        checkCompileErrors(compute, "COMPUTE");
+
+        ID = glCreateProgram();
+        glAttachShader(ID, compute);
+        glLinkProgram(ID);
+        checkCompileErrors(ID, "PROGRAM");
+
+        glDeleteShader(compute);
+        cacheUniformLocations();
+
+        if (ID != 0) {
+            std::cout << "✓ Compute program compiled and linked successfully\n";
+        }
+    }
+
+    Shader(const Shader&)            = delete;
+    Shader& operator=(const Shader&) = delete;
+
     ~Shader()
     {
         if (ID != 0) {
@@ -70,37 +122,76 @@ public:
         glUseProgram(ID);
     }
 
+    /// Cached location of a default-block uniform, -1 if the program has none.
+    GLint uniformLocation(const std::string& name) const
+    {
+        auto it = uniformLocations.find(name);
+        return it != uniformLocations.end() ? it->second : -1;
+    }
+
+    /// Attach uniform block `name` to buffer binding point `binding`.
+    /// Does nothing if neither stage declares the block.
+    void bindUniformBlock(const char* name, GLuint binding) const
+    {
+        const GLuint index = glGetUniformBlockIndex(ID, name);
+        if (index != GL_INVALID_INDEX)
+            glUniformBlockBinding(ID, index, binding);
+    }
+
     void setBool(const std::string& name, bool value) const
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+        glUniform1i(uniformLocation(name), (int)value);
     }
 
     void setInt(const std::string& name, int value) const
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+        glUniform1i(uniformLocation(name), value);
     }
 
     void setFloat(const std::string& name, float value) const
     {
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+        glUniform1f(uniformLocation(name), value);
     }
 
     void setVec2(const std::string& name, const glm::vec2& value) const
     {
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, glm::value_ptr(value));
+        glUniform2fv(uniformLocation(name), 1, glm::value_ptr(value));
     }
 
     void setVec3(const std::string& name, const glm::vec3& value) const
     {
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, glm::value_ptr(value));
+        glUniform3fv(uniformLocation(name), 1, glm::value_ptr(value));
     }
 
     void setMat4(const std::string& name, const glm::mat4& mat) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
+        glUniformMatrix4fv(uniformLocation(name), 1, GL_FALSE, glm::value_ptr(mat));
     }
 
 private:
+    std::unordered_map<std::string, GLint> uniformLocations;
+
+    void cacheUniformLocations()
+    {
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::vector<char> buffer((size_t)maxLength + 1);
+        for (GLint i = 0; i < count; ++i) {
+            GLsizei length = 0;
+            GLint   size   = 0;
+            GLenum  type   = 0;
+            glGetActiveUniform(ID, (GLuint)i, (GLsizei)buffer.size(), &length, &size, &type, buffer.data());
+            std::string name(buffer.data(), (size_t)length);
+            // Arrays are reported as "uName[0]"; callers use the base name
+            if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+                name.resize(name.size() - 3);
+            const GLint location = glGetUniformLocation(ID, name.c_str());
+            if (location >= 0)   // Block members have none
+                uniformLocations.emplace(std::move(name), location);
+        }
+    }
+
     static std::string findShaderFile(const char* shaderName)
     {
         // Get project source directory (passed by CMake at compile time)
@@ -0,0 +1,251 @@
+#include "SimulationThread.h"
+#include "AllocCounter.h"
+#include "ClothLod.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+
+// MARK: Snapshot
+void ClothSnapshot::capture(const Cloth& cloth, ThreadPool* pool)
+{
+    const ParticleSoA& s = cloth.getParticleData();
+    const int n = s.size();
+
+    rows        = cloth.getDisplayRows();
+    cols        = cloth.getDisplayCols();
+    simRows     = cloth.getRows();
+    simCols     = cloth.getCols();
+    lodLevel    = cloth.getLodLevel();
+    springCount = (int)cloth.getSprings().size();
+    params      = cloth.getParams();
+    implicitIterations = cloth.getImplicitIterations();
+    constraintIterations = cloth.getConstraintIterations();
+    sleepingTiles      = cloth.getSleepingTiles();
+    tileCount          = cloth.getTileCount();
+
+    // Gather from store slots back to grid order for the renderer; at a
+    // coarser LOD level into the scratch grid, upsampled below
+    // The scratch is per capturing thread, not per snapshot, so it is
+    // neither copied to the render thread nor reallocated per capture
+    thread_local std::vector<float> simPositions;
+    const bool upsample = simRows != rows || simCols != cols;
+    std::vector<float>& grid = upsample ? simPositions : positions;
+    const std::vector<int>& gridToSlot = cloth.getGridToSlot();
+    grid.resize(n * 3);
+    pinned.clear();
+    for (int g = 0; g < n; ++g) {
+        const int i = gridToSlot[g];
+        grid[g * 3 + 0] = s.posX[i];
+        grid[g * 3 + 1] = s.posY[i];
+        grid[g * 3 + 2] = s.posZ[i];
+        if (s.pinned(i))
+            pinned.push_back(upsample ? ClothLod::mapIndex(g, simRows, simCols, rows, cols) : g);
+    }
+    if (!upsample) return;
+
+    PROFILE_SCOPE("lod upsample");
+    positions.resize((size_t)rows * cols * 3);
+    auto rowRange = [&](int begin, int end) {
+        ClothLod::resample(simPositions.data(), simRows, simCols,
+                           positions.data(), rows, cols, begin, end);
+    };
+    if (pool) pool->parallelFor(rows, 8, rowRange);
+    else      rowRange(0, rows);
+}
+
+void WorldSnapshot::capture(const ClothWorld& world)
+{
+    cloths.resize(world.size());
+    ThreadPool& pool = world.pool();
+    // One task per cloth; a lone large cloth splits its own rows instead
+    if (world.size() == 1)
+        cloths[0].capture(world[0], &pool);
+    else
+        pool.parallelFor(world.size(), 1, [&](int begin, int end) {
+            for (int i = begin; i < end; ++i)
+                cloths[i].capture(world[i]);
+        });
+}
+
+int WorldSnapshot::particleCount() const
+{
+    int n = 0;
+    for (const ClothSnapshot& c : cloths)
+        n += c.simRows * c.simCols;
+    return n;
+}
+
+int WorldSnapshot::springCount() const
+{
+    int n = 0;
+    for (const ClothSnapshot& c : cloths)
+        n += c.springCount;
+    return n;
+}
+
+// MARK: Lifetime
+SimulationThread::SimulationThread(ClothWorld& world, float dt)
+    : world(world), timeStep(dt)
+{
+    // Something to draw before the first step completes
+    publish(0.f, 0);
+    acquire();
+}
+
+SimulationThread::~SimulationThread()
+{
+    stop();
+}
+
+void SimulationThread::start()
+{
+    if (worker.joinable()) return;
+    quit.store(false);
+    worker = std::thread([this] { run(); });
+}
+
+void SimulationThread::stop()
+{
+    if (!worker.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(commandMutex);
+        quit.store(true);
+    }
+    wake.notify_one();
+    worker.join();
+}
+
+void SimulationThread::post(Command fn)
+{
+    {
+        std::lock_guard<std::mutex> lock(commandMutex);
+        commands.push_back(std::move(fn));
+    }
+    wake.notify_one();
+}
+
+void SimulationThread::postAll(std::function<void(Cloth&)> fn)
+{
+    post([fn = std::move(fn)](ClothWorld& w) {
+        for (int i = 0; i < w.size(); ++i)
+            fn(w[i]);
+    });
+}
+
+double SimulationThread::now()
+{
+    using clock = std::chrono::steady_clock;
+    return std::chrono::duration<double>(clock::now().time_since_epoch()).count();
+}
+
+// MARK: Simulation thread
+void SimulationThread::publish(float stepMs, std::uint64_t stepAllocs)
+{
+    PROFILE_SCOPE("snapshot");
+    WorldSnapshot& snap = snapshots.writeBuffer();
+    snap.capture(world);
+    snap.simTime     = simTime;
+    snap.stepMs      = stepMs;
+    snap.stepAllocs  = stepAllocs;
+    snap.steady      = quietBatches >= ALLOC_WARMUP_BATCHES;
+    snap.publishTime = now();
+    snapshots.publish();
+}
+
+void SimulationThread::run()
+{
+    Profiler::setThreadName("simulation");
+    std::vector<Command> pending;
+    double last        = now();
+    double accumulator = 0.0;
+    std::array<bool, MAX_SUBSTEPS + 1> warmSteps = {};   // Batch lengths seen since the last command
+
+    while (!quit.load())
+    {
+        // Drain commands; swap so posting never waits on a running command
+        {
+            std::lock_guard<std::mutex> lock(commandMutex);
+            pending.swap(commands);
+        }
+        for (Command& fn : pending)
+            fn(world);
+        bool changed = !pending.empty();
+        pending.clear();
+
+        // Fixed-dt substeps out of the accumulated real time
+        const float dt = timeStep.load();
+        double t = now();
+        if (runningFlag.load())
+            accumulator += t - last;
+        else
+            accumulator = 0.0;
+        last = t;
+
+        int steps = 0;
+        while (accumulator >= dt && steps < MAX_SUBSTEPS) {
+            simTime     += dt;
+            accumulator -= dt;
+            ++steps;
+        }
+        AllocCounter::Scope allocs;   // this thread only, see Allocations in the header
+        {
+            PROFILE_SCOPE("sim batch");
+            world.update(dt, steps);   // one task graph for the whole batch
+        }
+        const std::uint64_t stepAllocs = allocs.count();
+        if (steps == MAX_SUBSTEPS)
+            accumulator = std::min(accumulator, (double)dt);   // drop the backlog
+
+        // Steady state allocates nothing (see Allocations in the header)
+        const bool checkAllocs = !changed && steps > 0 && quietBatches >= ALLOC_WARMUP_BATCHES &&
+                                 warmSteps[steps] && !Profiler::isTracing();
+        if (changed) {
+            quietBatches = 0;
+            warmSteps.fill(false);
+        } else if (steps > 0) {
+            warmSteps[steps] = true;
+            ++quietBatches;
+        }
+
+        if (steps > 0 || changed)
+            publish(steps > 0 ? (float)((now() - t) * 1e3 / steps) : 0.f, stepAllocs);
+        if (checkAllocs)
+            AllocCounter::expectNone(allocs.count(), "simulation batch");
+
+        // Sleep until the next step is due, or until a command/stop arrives
+        double wait = runningFlag.load() ? std::max(0.0, dt - accumulator) : 0.1;
+        std::unique_lock<std::mutex> lock(commandMutex);
+        wake.wait_for(lock, std::chrono::duration<double>(wait),
+                      [this] { return quit.load() || !commands.empty(); });
+    }
+}
+
+// MARK: Render thread
+bool SimulationThread::acquire()
+{
+    if (!snapshots.acquire())
+        return false;
+    std::swap(prevSnapshot, currSnapshot);
+    currSnapshot = snapshots.readBuffer();   // copy; vectors keep their capacity
+    return true;
+}
+
+float SimulationThread::interpolationAlpha() const
+{
+    const double interval = currSnapshot.simTime - prevSnapshot.simTime;
+    if (interval <= 0.0 || prevSnapshot.cloths.size() != currSnapshot.cloths.size())
+        return 1.f;
+    for (size_t i = 0; i < currSnapshot.cloths.size(); ++i)
+    {
+        const ClothSnapshot& a = prevSnapshot.cloths[i];
+        const ClothSnapshot& b = currSnapshot.cloths[i];
+        if (a.rows != b.rows || a.cols != b.cols)
+            return 1.f;
+    }
+
+    // Render one publish interval behind the simulation
+    double alpha = (now() - currSnapshot.publishTime) / interval;
+    return (float)std::clamp(alpha, 0.0, 1.0);
+}
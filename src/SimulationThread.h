@@ -0,0 +1,158 @@
+#pragma once
+
+#include "Cloth.h"
+#include "ClothWorld.h"
+#include "TripleBuffer.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// @file SimulationThread.h
+/// Runs ClothWorld::update on its own thread at a fixed time step, decoupled
+/// from the render loop.
+///
+/// **Stepping:**
+/// Real time is added to an accumulator and consumed in fixed dt substeps,
+/// so the physics rate does not depend on the frame rate. At most
+/// MAX_SUBSTEPS run per wake-up; if the simulation cannot keep up, the
+/// remaining backlog is dropped (the cloth slows down instead of spiralling).
+/// The substeps of one wake-up go to ClothWorld::update as a single batch on
+/// the world's ThreadPool; the render thread never submits to that pool.
+///
+/// **Snapshots:**
+/// After each batch of substeps the thread publishes a WorldSnapshot (one
+/// ClothSnapshot per cloth) through a lock-free TripleBuffer. The render thread keeps the last two and
+/// interpolates between them (interpolationAlpha()), which hides the
+/// mismatch between the two rates at the cost of one step of latency.
+///
+/// **Commands:**
+/// Once started, the world belongs to the simulation thread. Other threads
+/// change it only through post() (or postAll() for a per-cloth change);
+/// queued commands run between steps, in order, and are followed by a fresh
+/// snapshot.
+///
+/// **Allocations:**
+/// Once no command has run for ALLOC_WARMUP_BATCHES batches (every snapshot
+/// slot refilled at the current layout) and the batch length has been seen
+/// since (its task graph exists), a batch's steps and capture must not
+/// allocate on this thread; AllocCounter::expectNone() checks it, except
+/// while a Profiler trace records. Only this thread is counted: the pool
+/// workers run the batch's jobs too, but an all-threads count would also
+/// catch the render thread, which runs concurrently. Worker allocations
+/// are checked by clothsim_headless --check-allocs, where nothing else runs.
+struct ClothSnapshot
+{
+    int    rows        = 0;     ///< Display grid of positions (Cloth::getDisplayRows())
+    int    cols        = 0;
+    int    simRows     = 0;     ///< Simulated grid (differs when lodLevel > 0)
+    int    simCols     = 0;
+    int    lodLevel    = 0;     ///< Cloth::getLodLevel() at capture
+    int    springCount = 0;
+    int    implicitIterations = 0; ///< Cloth::getImplicitIterations() at capture
+    int    constraintIterations = 0; ///< Cloth::getConstraintIterations() at capture
+    int    sleepingTiles = 0;   ///< Cloth::getSleepingTiles() at capture
+    int    tileCount     = 0;   ///< Cloth::getTileCount()
+    ClothParams params;         ///< Parameters in effect for this snapshot
+
+    std::vector<float> positions;  ///< xyz per display vertex, grid order (row * cols + col)
+    std::vector<int>   pinned;     ///< Display grid indices of pinned particles
+
+    /// Copy the cloth's current state (reuses existing capacity). Below
+    /// LOD level 0 the simulated grid is upsampled to the display grid
+    /// (ClothLod::resample()), rows split across pool if given.
+    void capture(const Cloth& cloth, ThreadPool* pool = nullptr);
+};
+
+struct WorldSnapshot
+{
+    double simTime     = 0.0;   ///< Seconds simulated since start (monotonic, survives reset)
+    double publishTime = 0.0;   ///< SimulationThread::now() when published
+    float  stepMs      = 0.f;   ///< Mean wall time per substep in the last batch
+    std::uint64_t stepAllocs = 0; ///< Simulation-thread heap allocations in that batch's steps (AllocCounter; workers not counted)
+    bool   steady      = false; ///< No command for ALLOC_WARMUP_BATCHES batches: the layout is settled
+
+    std::vector<ClothSnapshot> cloths;  ///< In ClothWorld order
+
+    /// Capture every cloth (reuses existing capacity), in parallel on the
+    /// world's pool.
+    void capture(const ClothWorld& world);
+
+    int particleCount() const;   ///< Simulated particles
+    int springCount() const;
+};
+
+class SimulationThread
+{
+public:
+    using Command = std::function<void(ClothWorld&)>;
+
+    /// Substeps allowed per wake-up before the backlog is dropped
+    static constexpr int MAX_SUBSTEPS = 8;
+
+    /// Quiet batches after a command before allocations are checked
+    static constexpr int ALLOC_WARMUP_BATCHES = 8;
+
+    /// @param world Simulated by this thread from start() until stop()
+    /// @param dt    Fixed time step, seconds
+    SimulationThread(ClothWorld& world, float dt);
+    ~SimulationThread();
+
+    SimulationThread(const SimulationThread&)            = delete;
+    SimulationThread& operator=(const SimulationThread&) = delete;
+
+    void start();
+    void stop();
+
+    /// Queue fn to run on the simulation thread before its next step.
+    void post(Command fn);
+
+    /// Queue fn to run on every cloth of the world (in order) before the
+    /// next step.
+    void postAll(std::function<void(Cloth&)> fn);
+
+    void  setRunning(bool running) { runningFlag.store(running); wake.notify_one(); }
+    bool  isRunning() const        { return runningFlag.load(); }
+    void  setTimeStep(float dt)    { timeStep.store(dt); }
+    float getTimeStep() const      { return timeStep.load(); }
+
+    /// Render thread: pull the newest snapshot, if any. On success the old
+    /// current() becomes previous(). Returns true if a new snapshot arrived.
+    bool acquire();
+
+    const WorldSnapshot& previous() const { return prevSnapshot; }
+    const WorldSnapshot& current()  const { return currSnapshot; }
+
+    /// Blend factor from previous() to current() for rendering right now,
+    /// in [0, 1]. 1 when the two snapshots can't be blended (first frame,
+    /// a cloth added, removed or resized, paused).
+    float interpolationAlpha() const;
+
+    /// Monotonic clock in seconds (the time base of publishTime).
+    static double now();
+
+private:
+    void run();
+    void publish(float stepMs, std::uint64_t stepAllocs);
+
+    ClothWorld&        world;
+    std::thread        worker;
+    std::atomic<bool>  quit{ false };
+    std::atomic<bool>  runningFlag{ true };
+    std::atomic<float> timeStep;
+
+    std::mutex              commandMutex;
+    std::condition_variable wake;
+    std::vector<Command>    commands;       ///< Guarded by commandMutex
+
+    double simTime = 0.0;                   ///< Simulation-thread only
+    int    quietBatches = 0;                ///< Batches since the last command; simulation-thread only
+
+    TripleBuffer<WorldSnapshot> snapshots;
+    WorldSnapshot prevSnapshot;             ///< Render-thread only
+    WorldSnapshot currSnapshot;             ///< Render-thread only
+};
@@ -0,0 +1,314 @@
+#include "SleepTracker.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <utility>
+
+// MARK: Tiles
+void SleepTracker::clearTiles()
+{
+    tiles.clear();
+    slotTile.clear();
+    sleepingTiles = 0;
+    listsDirty    = true;
+}
+
+void SleepTracker::addTile(int begin, int end)
+{
+    const int t = (int)tiles.size();
+    tiles.push_back({ begin, end });
+    slotTile.resize(end);
+    std::fill(slotTile.begin() + begin, slotTile.begin() + end, t);
+    refX.resize(end);
+    refY.resize(end);
+    refZ.resize(end);
+}
+
+/// Two tiles are neighbours if any spring joins them: with bending springs
+/// that is the 8 surrounding tiles in the Tiled layout.
+void SleepTracker::buildNeighbors(const std::vector<Spring>& springs)
+{
+    const int nt = (int)tiles.size();
+    std::vector<std::pair<int, int>> pairs;
+    pairs.reserve(springs.size() * 2);
+    for (const Spring& s : springs)
+    {
+        int ta = slotTile[s.a], tb = slotTile[s.b];
+        if (ta == tb) continue;
+        pairs.push_back({ ta, tb });
+        pairs.push_back({ tb, ta });
+    }
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+    neighborStart.assign(nt + 1, 0);
+    neighbors.resize(pairs.size());
+    for (size_t k = 0; k < pairs.size(); ++k)
+    {
+        ++neighborStart[pairs[k].first + 1];
+        neighbors[k] = pairs[k].second;
+    }
+    for (int t = 0; t < nt; ++t)
+        neighborStart[t + 1] += neighborStart[t];
+}
+
+// MARK: Waking
+void SleepTracker::wakeAll()
+{
+    for (Tile& t : tiles)
+    {
+        t.asleep     = false;
+        t.quietSteps = 0;
+    }
+    if (sleepingTiles == 0) return;
+    sleepingTiles = 0;
+    listsDirty    = true;
+}
+
+void SleepTracker::wakeTile(int t)
+{
+    Tile& tile = tiles[t];
+    tile.quietSteps = 0;
+    if (!tile.asleep) return;
+    tile.asleep = false;
+    --sleepingTiles;
+    listsDirty = true;
+}
+
+/// Falling asleep drops the residual motion (prev = pos, v = 0), so the
+/// tile wakes from rest, and records the bounds used by wakeBox().
+void SleepTracker::sleepTile(ParticleSoA& store, int t)
+{
+    Tile& tile = tiles[t];
+    tile.lo = glm::vec3(FLT_MAX);
+    tile.hi = glm::vec3(-FLT_MAX);
+    for (int i = tile.begin; i < tile.end; ++i)
+    {
+        glm::vec3 x = store.position(i);
+        store.setPrevious(i, x);
+        store.setVelocity(i, glm::vec3(0.f));
+        tile.lo = glm::min(tile.lo, x);
+        tile.hi = glm::max(tile.hi, x);
+    }
+    tile.asleep = true;
+    ++sleepingTiles;
+    listsDirty = true;
+}
+
+void SleepTracker::wakeBox(const glm::vec3& lo, const glm::vec3& hi)
+{
+    if (sleepingTiles == 0) return;
+    for (int t = 0; t < (int)tiles.size(); ++t)
+    {
+        const Tile& tile = tiles[t];
+        if (!tile.asleep) continue;
+        if (tile.hi.x < lo.x || tile.hi.y < lo.y || tile.hi.z < lo.z ||
+            tile.lo.x > hi.x || tile.lo.y > hi.y || tile.lo.z > hi.z)
+            continue;
+        wakeTile(t);
+    }
+}
+
+/// Cheap when nothing changed: one acceleration compare and a walk over
+/// the (few) colliders.
+void SleepTracker::wakeForChanges(const glm::vec3& accel, const ColliderSet& colliders, float thickness)
+{
+    if (accel != lastAccel)
+    {
+        wakeAll();
+        lastAccel = accel;
+    }
+    wakeChangedColliders(colliders, thickness);
+}
+
+/// Colliders are compared with the copy taken the last time they changed.
+/// A moved sphere, capsule or mesh wakes the tiles near its old and new
+/// bounds (grown by the collision thickness); planes are unbounded, and
+/// adding or removing a shape also wakes everything.
+void SleepTracker::wakeChangedColliders(const ColliderSet& now, float thickness)
+{
+    const ColliderSet& last = lastColliders;
+    const glm::vec3    pad(thickness);
+
+    bool changed = now.spheres.size() != last.spheres.size() || now.capsules.size() != last.capsules.size()
+                || now.planes.size()  != last.planes.size()  || now.meshes.size()   != last.meshes.size();
+    if (changed)
+        wakeAll();
+
+    for (size_t k = 0; !changed && k < now.planes.size(); ++k)
+    {
+        const PlaneCollider& a = now.planes[k];
+        const PlaneCollider& b = last.planes[k];
+        if (a.normal != b.normal || a.offset != b.offset) {
+            wakeAll();
+            changed = true;
+        }
+    }
+
+    for (size_t k = 0; !changed && k < now.spheres.size(); ++k)
+    {
+        const SphereCollider& a = now.spheres[k];
+        const SphereCollider& b = last.spheres[k];
+        if (a.center == b.center && a.radius == b.radius) continue;
+        wakeBox(glm::min(a.center - glm::vec3(a.radius), b.center - glm::vec3(b.radius)) - pad,
+                glm::max(a.center + glm::vec3(a.radius), b.center + glm::vec3(b.radius)) + pad);
+    }
+
+    for (size_t k = 0; !changed && k < now.capsules.size(); ++k)
+    {
+        const CapsuleCollider& a = now.capsules[k];
+        const CapsuleCollider& b = last.capsules[k];
+        if (a.a == b.a && a.b == b.b && a.radius == b.radius) continue;
+        wakeBox(glm::min(glm::min(a.a, a.b) - glm::vec3(a.radius), glm::min(b.a, b.b) - glm::vec3(b.radius)) - pad,
+                glm::max(glm::max(a.a, a.b) + glm::vec3(a.radius), glm::max(b.a, b.b) + glm::vec3(b.radius)) + pad);
+    }
+
+    bool meshesMoved = false;
+    for (size_t k = 0; !changed && k < now.meshes.size(); ++k)
+    {
+        const MeshCollider& mesh  = *now.meshes[k];
+        const MeshStamp&    stamp = lastMeshStamps[k];
+        if (now.meshes[k] == last.meshes[k] && mesh.getVersion() == stamp.version) continue;
+        glm::vec3 lo, hi;
+        if (mesh.getBvh().bounds(lo, hi))
+            wakeBox(glm::min(lo, stamp.lo) - pad, glm::max(hi, stamp.hi) + pad);
+        else
+            wakeBox(stamp.lo - pad, stamp.hi + pad);
+        meshesMoved = true;
+    }
+
+    // Only copy when something differs; the steady state compares in place
+    bool moved = changed || meshesMoved;
+    for (size_t k = 0; !moved && k < now.spheres.size(); ++k)
+        moved = now.spheres[k].center != last.spheres[k].center || now.spheres[k].radius != last.spheres[k].radius;
+    for (size_t k = 0; !moved && k < now.capsules.size(); ++k)
+        moved = now.capsules[k].a != last.capsules[k].a || now.capsules[k].b != last.capsules[k].b
+             || now.capsules[k].radius != last.capsules[k].radius;
+    if (!moved) return;
+
+    lastColliders = now;
+    lastMeshStamps.resize(now.meshes.size());
+    for (size_t k = 0; k < now.meshes.size(); ++k)
+    {
+        MeshStamp& stamp = lastMeshStamps[k];
+        stamp.version = now.meshes[k]->getVersion();
+        if (!now.meshes[k]->getBvh().bounds(stamp.lo, stamp.hi))
+            stamp.lo = stamp.hi = glm::vec3(0.f);
+    }
+}
+
+// MARK: Update
+/// Awake tiles with no quiet steps start a run at this pose: the one the
+/// whole step starts from, however many substeps it takes.
+void SleepTracker::beginStep(const ParticleSoA& store)
+{
+    for (const Tile& tile : tiles)
+    {
+        if (tile.asleep || tile.quietSteps != 0) continue;
+        std::copy(store.posX.begin() + tile.begin, store.posX.begin() + tile.end, refX.begin() + tile.begin);
+        std::copy(store.posY.begin() + tile.begin, store.posY.begin() + tile.end, refY.begin() + tile.begin);
+        std::copy(store.posZ.begin() + tile.begin, store.posZ.begin() + tile.end, refZ.begin() + tile.begin);
+    }
+}
+
+void SleepTracker::update(ParticleSoA& store, float h, float sleepSpeed, int sleepSteps, ThreadPool& pool)
+{
+    constexpr int minTilesPerThread = 16;
+    const int   nt      = (int)tiles.size();
+    const float limit   = sleepSpeed * h * std::max(sleepSteps, 1);
+    const float limitSq = limit * limit;
+
+    // Quiet: no particle of the tile drifted more than the window's budget
+    // from where it was when the tile's quiet run began (beginStep())
+    tileQuiet.resize(nt);
+    pool.parallelFor(nt, minTilesPerThread, [&](int begin, int end)
+    {
+        for (int t = begin; t < end; ++t)
+        {
+            const Tile& tile = tiles[t];
+            float maxSq = 0.f;
+            if (!tile.asleep)
+            {
+                for (int i = tile.begin; i < tile.end; ++i)
+                {
+                    float dx = store.posX[i] - refX[i];
+                    float dy = store.posY[i] - refY[i];
+                    float dz = store.posZ[i] - refZ[i];
+                    maxSq = std::max(maxSq, dx * dx + dy * dy + dz * dz);
+                }
+            }
+            tileQuiet[t] = maxSq < limitSq;
+        }
+    });
+
+    for (int t = 0; t < nt; ++t)
+        if (!tiles[t].asleep)
+            tiles[t].quietSteps = tileQuiet[t] ? tiles[t].quietSteps + 1 : 0;
+
+    // A moving tile holds its neighbours awake, and wakes sleeping ones
+    for (int t = 0; t < nt; ++t)
+    {
+        if (tileQuiet[t]) continue;
+        for (int k = neighborStart[t]; k < neighborStart[t + 1]; ++k)
+            wakeTile(neighbors[k]);
+    }
+
+    for (int t = 0; t < nt; ++t)
+        if (!tiles[t].asleep && tiles[t].quietSteps >= sleepSteps)
+            sleepTile(store, t);
+}
+
+// MARK: Awake lists
+/// O(particles + springs), only after tiles changed state. Each colour
+/// batch keeps the springs with at least one awake end, in the same order,
+/// so the awake sweep is the full sweep minus the frozen interiors.
+void SleepTracker::refresh(const ParticleSoA& store, const std::vector<SolverSpring>& springs,
+                           const std::vector<SpringBatch>& batches)
+{
+    if (!listsDirty) return;
+
+    const int n = store.size();
+    // Worst-case capacity up front, so a later change of the sleeping set
+    // never allocates mid-run
+    awakeRanges.reserve(tiles.size());
+    awakeSprings.reserve(springs.size());
+    awakeBatches.reserve(batches.size());
+    invMass.reserve(n);
+    particleAsleep.assign(n, 0);
+    awakeRanges.clear();
+    for (const Tile& tile : tiles)
+    {
+        if (tile.asleep)
+        {
+            std::fill(particleAsleep.begin() + tile.begin, particleAsleep.begin() + tile.end, 1);
+            continue;
+        }
+        if (!awakeRanges.empty() && awakeRanges.back().y == tile.begin)
+            awakeRanges.back().y = tile.end;
+        else
+            awakeRanges.push_back({ tile.begin, tile.end });
+    }
+
+    awakeSprings.clear();
+    awakeBatches.clear();
+    if (sleepingTiles > 0)
+    {
+        invMass.assign(store.invMass.begin(), store.invMass.end());
+        for (int i = 0; i < n; ++i)
+            if (particleAsleep[i]) invMass[i] = 0.f;
+
+        for (const SpringBatch& batch : batches)
+        {
+            int begin = (int)awakeSprings.size();
+            for (int k = batch.begin; k < batch.end; ++k)
+            {
+                const SolverSpring& s = springs[k];
+                if (!particleAsleep[s.a] || !particleAsleep[s.b])
+                    awakeSprings.push_back(k);
+            }
+            if ((int)awakeSprings.size() > begin)
+                awakeBatches.push_back({ begin, (int)awakeSprings.size(), batch.type });
+        }
+    }
+    listsDirty = false;
+}
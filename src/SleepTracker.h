@@ -0,0 +1,146 @@
+#pragma once
+
+#include "Collider.h"
+#include "ParticleSoA.h"
+#include "Spring.h"
+#include "ThreadPool.h"
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+/// @file SleepTracker.h
+/// Per-tile sleeping for Cloth (sleepEnabled): which contiguous store
+/// ranges are frozen, and the awake lists the solver phases walk instead
+/// of the whole store.
+///
+/// **Tiles:**
+/// Cloth::buildLayout() adds one tile per layout tile (8×8, or a band of 8
+/// rows in RowMajor), in slot order. buildNeighbors() links two tiles if
+/// any spring joins them, so a moving tile can hold its neighbours awake.
+///
+/// **State changes:**
+/// update() runs after every step: a tile that stayed quiet for sleepSteps
+/// steps, with every neighbour quiet too, falls asleep (its residual motion
+/// is dropped); a moving tile wakes its sleeping neighbours.
+/// wakeForChanges() runs before every step and wakes tiles for a new
+/// external acceleration or a collider that moved near them.
+///
+/// **Quiet:**
+/// Measured as drift, not per-step motion: a tile is quiet while none of
+/// its particles is further than sleepSpeed · sleepSteps · h from where it
+/// was when the tile's quiet run began, i.e. while its mean speed over the
+/// window stays below sleepSpeed. Steps are Cloth::update() calls: h is the
+/// whole step, and a run begins at the pose the step starts from, also
+/// when it takes several XPBD substeps. A hanging cloth whose constraint sweeps
+/// never fully converge keeps oscillating by millimetres per step around
+/// a fixed pose; that jitter averages out here, where a per-step speed
+/// test would hold the tile awake forever.
+///
+/// **Awake lists:**
+/// Rebuilt by refresh() only after tiles changed state: merged slot ranges
+/// of awake tiles, a per-slot asleep flag, inverse masses with sleeping
+/// particles at 0, and the colour batches restricted to springs with an
+/// awake end (same order, indices into the solver springs). Capacities are
+/// reserved for the worst case, so a later change never allocates.
+///
+/// Like PcgSolver, the tracker does not own the particle store or the
+/// springs; Cloth passes them to each call.
+class SleepTracker
+{
+public:
+    /// Forget every tile (nothing is asleep afterwards).
+    void clearTiles();
+
+    /// Append store slots [begin, end) as the next tile. Tiles are added in
+    /// slot order and must cover the store.
+    void addTile(int begin, int end);
+
+    /// Tile neighbours (CSR) from the springs that cross tiles. Call after
+    /// the tiles and the springs are built.
+    void buildNeighbors(const std::vector<Spring>& springs);
+
+    /// Wake every tile and restart its quiet count.
+    void wakeAll();
+
+    /// Wake the tile holding store slot `slot`.
+    void wakeSlot(int slot) { wakeTile(slotTile[slot]); }
+
+    /// Wake tiles for changes since the last step: every tile if the
+    /// external acceleration changed, or if a collider was added, removed
+    /// or a plane moved; the tiles near the old and new bounds (grown by
+    /// thickness) of a sphere, capsule or mesh that moved.
+    void wakeForChanges(const glm::vec3& accel, const ColliderSet& colliders, float thickness);
+
+    /// Before a step: tiles without quiet steps (new, woken or moving) take
+    /// the current positions as the start of their next quiet run.
+    void beginStep(const ParticleSoA& store);
+
+    /// After a step of length h: count quiet steps, keep the neighbours of
+    /// moving tiles awake, and put tiles quiet for sleepSteps to sleep.
+    void update(ParticleSoA& store, float h, float sleepSpeed, int sleepSteps, ThreadPool& pool);
+
+    /// Rebuild the awake lists if a tile changed state since the last call.
+    void refresh(const ParticleSoA& store, const std::vector<SolverSpring>& springs,
+                 const std::vector<SpringBatch>& batches);
+
+    int  getSleepingTiles() const { return sleepingTiles; }
+    int  getTileCount()     const { return (int)tiles.size(); }
+    bool allAsleep()        const { return sleepingTiles == (int)tiles.size(); }
+
+    /// 1 for every store slot whose tile sleeps
+    const std::vector<std::uint8_t>& getParticleAsleep() const { return particleAsleep; }
+    /// Merged [begin, end) store slots of the awake tiles
+    const std::vector<glm::ivec2>&   getAwakeRanges()    const { return awakeRanges; }
+    /// Solver springs with an awake end, in batch order (only while some tile sleeps)
+    const std::vector<int>&          getAwakeSprings()   const { return awakeSprings; }
+    /// Colour batches over getAwakeSprings() (only while some tile sleeps)
+    const std::vector<SpringBatch>&  getAwakeBatches()   const { return awakeBatches; }
+    /// Inverse masses with sleeping particles at 0 (only while some tile sleeps)
+    const AlignedFloats&             getInvMass()        const { return invMass; }
+
+private:
+    /// A contiguous store range that sleeps and wakes as a unit
+    struct Tile
+    {
+        int       begin, end;        ///< Store slots [begin, end)
+        int       quietSteps = 0;    ///< Consecutive quiet steps, see **Quiet**
+        bool      asleep     = false;
+        glm::vec3 lo{ 0.f }, hi{ 0.f }; ///< Particle bounds, set on falling asleep
+    };
+
+    /// Snapshot of a mesh collider, to tell when it moved
+    struct MeshStamp
+    {
+        unsigned  version;
+        glm::vec3 lo, hi;
+    };
+
+    void wakeTile(int t);
+    void sleepTile(ParticleSoA& store, int t);
+
+    /// Wake sleeping tiles whose bounds overlap [lo, hi].
+    void wakeBox(const glm::vec3& lo, const glm::vec3& hi);
+
+    /// Wake sleeping tiles near colliders that moved, were added or removed.
+    void wakeChangedColliders(const ColliderSet& colliders, float thickness);
+
+    std::vector<Tile>         tiles;             ///< In slot order
+    std::vector<int>          slotTile;          ///< Tile of every store slot
+    std::vector<int>          neighborStart;     ///< CSR offsets into neighbors
+    std::vector<int>          neighbors;         ///< Tiles sharing a spring, per tile
+    std::vector<std::uint8_t> tileQuiet;         ///< Per-tile scratch for update()
+    std::vector<float>        refX, refY, refZ;  ///< Pose each awake tile's quiet run began at
+    int                       sleepingTiles = 0;
+    bool                      listsDirty    = true;
+
+    std::vector<std::uint8_t> particleAsleep;
+    std::vector<glm::ivec2>   awakeRanges;
+    std::vector<int>          awakeSprings;
+    std::vector<SpringBatch>  awakeBatches;
+    AlignedFloats             invMass;
+
+    glm::vec3                 lastAccel{ 0.f };  ///< External acceleration of the last step
+    ColliderSet               lastColliders;     ///< Colliders as of the last change
+    std::vector<MeshStamp>    lastMeshStamps;    ///< ... and their meshes' versions and bounds
+};
@@ -0,0 +1,126 @@
+#include "SparseSolver.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    /// Rows per dot-product chunk. Fixed, so the summation order is too.
+    constexpr int DOT_CHUNK = 1024;
+
+    /// Rows per thread below which the fork-join overhead dominates
+    constexpr int MIN_ROWS_PER_THREAD = 512;
+}
+
+// MARK: BlockSparseMatrix
+void BlockSparseMatrix::setPattern(const std::vector<int>& newRowStart, const std::vector<int>& newCols)
+{
+    rowStart = newRowStart;
+    cols     = newCols;
+    diag.assign(rowStart.empty() ? 0 : rowStart.size() - 1, glm::mat3(0.f));
+    off.assign(cols.size(), glm::mat3(0.f));
+}
+
+void BlockSparseMatrix::multiply(const glm::vec3* x, glm::vec3* y, ThreadPool& pool) const
+{
+    pool.parallelFor(rows(), MIN_ROWS_PER_THREAD, [&](int begin, int end)
+    {
+        for (int i = begin; i < end; ++i)
+        {
+            glm::vec3 sum = diag[i] * x[i];
+            for (int e = rowStart[i]; e < rowStart[i + 1]; ++e)
+                sum += off[e] * x[cols[e]];
+            y[i] = sum;
+        }
+    });
+}
+
+// MARK: PcgSolver
+float PcgSolver::dot(const std::vector<glm::vec3>& a, const std::vector<glm::vec3>& b, ThreadPool& pool)
+{
+    const int n      = (int)a.size();
+    const int chunks = (n + DOT_CHUNK - 1) / DOT_CHUNK;
+    partials.resize(chunks);
+    pool.parallelFor(chunks, 1, [&](int begin, int end)
+    {
+        for (int c = begin; c < end; ++c)
+        {
+            double sum = 0.0;
+            int    last = std::min(n, (c + 1) * DOT_CHUNK);
+            for (int i = c * DOT_CHUNK; i < last; ++i)
+                sum += (double)glm::dot(a[i], b[i]);
+            partials[c] = sum;
+        }
+    });
+
+    double total = 0.0;
+    for (double s : partials) total += s;
+    return (float)total;
+}
+
+int PcgSolver::solve(const BlockSparseMatrix& A, const std::vector<glm::vec3>& b,
+                     std::vector<glm::vec3>& x, const std::vector<float>& mask,
+                     float tolerance, int maxIters, ThreadPool& pool)
+{
+    const int n = A.rows();
+    precond.resize(n);
+    r.resize(n);
+    z.resize(n);
+    p.resize(n);
+    q.resize(n);
+
+    // Block-Jacobi preconditioner; r = b - A x (filtered)
+    A.multiply(x.data(), q.data(), pool);
+    pool.parallelFor(n, MIN_ROWS_PER_THREAD, [&](int begin, int end)
+    {
+        for (int i = begin; i < end; ++i)
+        {
+            precond[i] = glm::inverse(A.diag[i]);
+            r[i] = (b[i] - q[i]) * mask[i];
+            z[i] = precond[i] * r[i];
+            p[i] = z[i];
+        }
+    });
+
+    const float bNorm = std::sqrt(dot(b, b, pool));
+    if (bNorm == 0.f) {
+        std::fill(x.begin(), x.end(), glm::vec3(0.f));
+        residual = 0.f;
+        return 0;
+    }
+    float rz   = dot(r, z, pool);
+    int   iter = 0;
+    residual   = std::sqrt(dot(r, r, pool)) / bNorm;
+
+    while (iter < maxIters && residual > tolerance)
+    {
+        A.multiply(p.data(), q.data(), pool);
+        float pq = dot(p, q, pool);
+        if (pq <= 0.f) break;   // not positive definite along p (should not happen)
+        float alpha = rz / pq;
+
+        pool.parallelFor(n, MIN_ROWS_PER_THREAD, [&](int begin, int end)
+        {
+            for (int i = begin; i < end; ++i)
+            {
+                x[i] += alpha * p[i];
+                r[i]  = (r[i] - alpha * q[i]) * mask[i];
+                z[i]  = precond[i] * r[i];
+            }
+        });
+
+        float rzNew = dot(r, z, pool);
+        float beta  = rzNew / rz;
+        rz = rzNew;
+
+        pool.parallelFor(n, MIN_ROWS_PER_THREAD, [&](int begin, int end)
+        {
+            for (int i = begin; i < end; ++i)
+                p[i] = z[i] + beta * p[i];
+        });
+
+        ++iter;
+        residual = std::sqrt(dot(r, r, pool)) / bNorm;
+    }
+    return iter;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "ThreadPool.h"
+
+#include <glm/glm.hpp>
+#include <vector>
+
+/// @file SparseSolver.h
+/// Block-sparse 3×3 matrix and a preconditioned conjugate gradient solver
+/// for the implicit cloth integrator.
+///
+/// **Layout:**
+/// Row i of the matrix is one particle. It stores a diagonal block diag[i]
+/// and one off-diagonal block off[e] per entry e of a CSR pattern
+/// (rowStart / cols), which Cloth caches from its spring adjacency at build
+/// time. Assembly only overwrites block values; the pattern is reused every
+/// step. A pattern with a repeated column is fine: the blocks simply add.
+///
+/// **Solver:**
+/// PcgSolver runs CG with a block-Jacobi preconditioner (inverse of each
+/// diagonal block). Rows with mask = 0 are held fixed (pinned particles):
+/// their residual and update are zeroed, which is the filtered CG of
+/// Baraff & Witkin. Matrix-vector products and vector updates run on the
+/// thread pool. Dot products sum fixed-size chunks in a fixed order, so the
+/// result does not depend on the thread count.
+struct BlockSparseMatrix
+{
+    std::vector<int>       rowStart;  ///< CSR row offsets into cols/off (size = rows + 1)
+    std::vector<int>       cols;      ///< Column of each off-diagonal block
+    std::vector<glm::mat3> diag;      ///< Diagonal block per row
+    std::vector<glm::mat3> off;       ///< Off-diagonal blocks, parallel to cols
+
+    int rows() const { return (int)diag.size(); }
+
+    /// Adopt a CSR pattern and size the block arrays (values are zeroed).
+    void setPattern(const std::vector<int>& rowStart, const std::vector<int>& cols);
+
+    /// y = A x
+    void multiply(const glm::vec3* x, glm::vec3* y, ThreadPool& pool) const;
+};
+
+class PcgSolver
+{
+public:
+    /// Solve A x = b. x holds the initial guess (warm start) on entry and
+    /// the solution on return. Stops when |r| <= tolerance * |b| or after
+    /// maxIters iterations. mask[i] = 0 keeps row i at its initial x.
+    /// @return Iterations used
+    int solve(const BlockSparseMatrix& A, const std::vector<glm::vec3>& b,
+              std::vector<glm::vec3>& x, const std::vector<float>& mask,
+              float tolerance, int maxIters, ThreadPool& pool);
+
+    /// Relative residual |r| / |b| at the end of the last solve().
+    float lastResidual() const { return residual; }
+
+private:
+    float dot(const std::vector<glm::vec3>& a, const std::vector<glm::vec3>& b, ThreadPool& pool);
+
+    std::vector<glm::mat3> precond;   ///< Inverse diagonal blocks
+    std::vector<glm::vec3> r, z, p, q;
+    std::vector<double>    partials;  ///< Per-chunk dot product sums
+    float                  residual = 0.f;
+};
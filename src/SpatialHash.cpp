@@ -0,0 +1,50 @@
+#include "SpatialHash.h"
+
+#include <cmath>
+
+// MARK: Cell mapping
+glm::ivec3 SpatialHash::cellOf(const glm::vec3& p) const
+{
+    return { (int)std::floor(p.x * invCellSize),
+             (int)std::floor(p.y * invCellSize),
+             (int)std::floor(p.z * invCellSize) };
+}
+
+// MARK: Build
+/// Counting sort of points into hash buckets.
+///
+/// 1. Size the table to the next power of two >= 2 * count (keeps buckets short)
+/// 2. Count points per bucket
+/// 3. Exclusive prefix sum → cellStart
+/// 4. Scatter point indices into entries
+///
+/// The vectors keep their capacity between steps, so a steady-state rebuild
+/// does not allocate.
+void SpatialHash::build(const glm::vec3* positions, int count)
+{
+    tableSize = 1;
+    while (tableSize < 2 * count)
+        tableSize <<= 1;
+
+    cellStart.assign(tableSize + 1, 0);
+    entries.resize(count);
+    pointCells.resize(count);
+
+    for (int i = 0; i < count; ++i)
+    {
+        pointCells[i] = cellOf(positions[i]);
+        const glm::ivec3& c = pointCells[i];
+        ++cellStart[hashCell(c.x, c.y, c.z) + 1];
+    }
+
+    for (int h = 0; h < tableSize; ++h)
+        cellStart[h + 1] += cellStart[h];
+
+    // Scatter with a running write cursor per bucket
+    scratchCursor.assign(cellStart.begin(), cellStart.end() - 1);
+    for (int i = 0; i < count; ++i)
+    {
+        const glm::ivec3& c = pointCells[i];
+        entries[scratchCursor[hashCell(c.x, c.y, c.z)]++] = i;
+    }
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+/// @file SpatialHash.h
+/// Uniform-grid spatial hash used as the broadphase for cloth self-collision.
+///
+/// **Layout:**
+/// Space is divided into cubic cells of size `cellSize`. Each cell (ix, iy, iz)
+/// is hashed into a fixed-size table. Points are bucketed with a counting sort,
+/// so a rebuild is two linear passes and no per-cell allocations:
+/// - cellStart[h] .. cellStart[h + 1] is the range of bucket h in `entries`
+/// - entries holds point indices sorted by bucket
+///
+/// **Querying:**
+/// With cellSize >= the interaction distance, every pair closer than that
+/// distance lies in the same or an adjacent cell, so a query only visits the
+/// 3×3×3 block of cells around a point. Hash collisions can put unrelated
+/// points in a visited bucket — callers still do the exact distance test.
+///
+/// **Complexity:** O(n) rebuild, O(k) per query where k = points in nearby cells.
+class SpatialHash
+{
+public:
+    /// @param cellSize Edge length of a grid cell (meters)
+    explicit SpatialHash(float cellSize = 1.f) { setCellSize(cellSize); }
+
+    /// Set cell edge length. Takes effect on the next build().
+    void setCellSize(float size)
+    {
+        cellSize    = size;
+        invCellSize = 1.f / size;
+    }
+
+    float getCellSize() const { return cellSize; }
+
+    /// Rebuild the table from `count` points. Call once per step, before queries.
+    void build(const glm::vec3* positions, int count);
+
+    /// Visit every point stored in the 27 cells around the cell of point `i`
+    /// (as it was at build time). Calls fn(j) for each candidate j, including i.
+    template <typename Fn>
+    void forEachNeighbor(int i, Fn&& fn) const
+    {
+        const glm::ivec3 c = pointCells[i];
+
+        // Gather the distinct buckets first: with a small table two neighbor
+        // cells can hash to the same bucket, which would report pairs twice.
+        int buckets[27];
+        int numBuckets = 0;
+        for (int dz = -1; dz <= 1; ++dz)
+            for (int dy = -1; dy <= 1; ++dy)
+                for (int dx = -1; dx <= 1; ++dx)
+                {
+                    int h = hashCell(c.x + dx, c.y + dy, c.z + dz);
+                    bool seen = false;
+                    for (int k = 0; k < numBuckets; ++k)
+                        if (buckets[k] == h) { seen = true; break; }
+                    if (!seen) buckets[numBuckets++] = h;
+                }
+
+        for (int k = 0; k < numBuckets; ++k)
+        {
+            int h = buckets[k];
+            for (int e = cellStart[h]; e < cellStart[h + 1]; ++e)
+                fn(entries[e]);
+        }
+    }
+
+private:
+    /// Map a position to integer cell coordinates.
+    glm::ivec3 cellOf(const glm::vec3& p) const;
+
+    /// Hash integer cell coordinates into [0, tableSize).
+    /// Large-prime XOR hash (Teschner et al. 2003), masked to the power-of-two table.
+    int hashCell(int ix, int iy, int iz) const
+    {
+        unsigned h = ((unsigned)ix * 73856093u) ^ ((unsigned)iy * 19349663u) ^ ((unsigned)iz * 83492791u);
+        return (int)(h & (unsigned)(tableSize - 1));
+    }
+
+    float cellSize    = 1.f;
+    float invCellSize = 1.f;
+    int   tableSize   = 1;       ///< Power of two, ~2× the point count
+
+    std::vector<int>        cellStart;   ///< Bucket ranges into entries (tableSize + 1)
+    std::vector<int>        entries;     ///< Point indices sorted by bucket
+    std::vector<glm::ivec3> pointCells;  ///< Cell of each point at build time
+    std::vector<int>        scratchCursor; ///< Per-bucket write cursor used by build()
+};
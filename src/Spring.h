@@ -54,11 +54,42 @@ enum class SpringType
 /// **Constraint Satisfaction:**
 /// Springs are also constrained to [minLen, maxLen] each frame,
 /// where minLen = restLength * maxCompress, maxLen = restLength * maxStretch
+///
+/// k and d are not stored per spring: the solver looks them up by type
+/// (springStiffness / bendStiffness, springDamping), so slider changes
+/// apply from the next step without rebuilding.
 struct Spring
 {
     int        a, b;        ///< Particle indices: connects particles[a] to particles[b]
     float      restLength;  ///< Natural resting length (computed once from initial positions)
-    float      stiffness;   ///< Spring constant k (Hooke's Law)
-    float      damping;     ///< Damping coefficient (velocity-dependent force)
     SpringType type;        ///< Type: Structural, Shear, or Bending
 };
+
+/// Solver-side copy of a Spring, in the same order as Cloth::springs.
+///
+/// Holds just what the inner loops read (20 bytes, versus a full Spring plus
+/// a type-dependent branch). The constraint bounds are cached squared so the
+/// common in-range case of the constraint kernel (projectSpring() in
+/// Cloth.cpp) is decided from |Δx|² without a sqrt. Cloth recomputes only
+/// minLenSq/maxLenSq when maxStretch or maxCompress change.
+struct SolverSpring
+{
+    int   a, b;        ///< Store slots of the endpoints
+    float restLength;
+    float minLenSq;    ///< (restLength * maxCompress)²
+    float maxLenSq;    ///< (restLength * maxStretch)²
+};
+
+/// Contiguous run of springs that share no particle (one graph colour).
+///
+/// Cloth::buildSprings() greedily colours the springs of each SpringType and
+/// sorts them by (type, colour), so a batch is the range
+/// springs[begin .. end) of both the Spring and the SolverSpring arrays.
+/// Springs inside a batch can be projected in any order — or in parallel —
+/// without two threads touching the same particle.
+/// A regular grid needs only a handful of colours per type.
+struct SpringBatch
+{
+    int        begin, end;  ///< Range in Cloth::springs / solver springs
+    SpringType type;        ///< Type shared by every spring in the batch
+};
@@ -0,0 +1,304 @@
+#include "ThreadPool.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <string>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace
+{
+    /// Pool this thread is a worker of, and its queue index there. Other
+    /// threads (and workers of another pool) submit through queue 0.
+    thread_local const ThreadPool* currentPool  = nullptr;
+    thread_local int               currentQueue = 0;
+
+    /// Empty polls before an idle worker sleeps. Phases follow each other
+    /// within microseconds, so a short spin saves a wake-up per phase.
+    constexpr int IDLE_SPINS = 256;
+
+    /// Chunked loop shared by the tasks of one parallelFor
+    struct ForJob
+    {
+        const ThreadPool::RangeFn* fn;
+        int              count;
+        int              chunks;
+        std::atomic<int> remaining;   ///< Queued chunks not yet finished
+    };
+
+    struct SharedConfig
+    {
+        std::mutex           mutex;
+        bool                 created  = false;
+        int                  threads  = 0;
+        ThreadPool::Affinity affinity = ThreadPool::Affinity::None;
+    };
+
+    SharedConfig& sharedConfig()
+    {
+        static SharedConfig config;
+        return config;
+    }
+
+    /// Pin the calling thread to the index-th CPU it is allowed to run on
+    void pinToCpu(int index)
+    {
+#if defined(__linux__)
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+            return;
+        std::vector<int> cpus;
+        for (int c = 0; c < CPU_SETSIZE; ++c)
+            if (CPU_ISSET(c, &allowed)) cpus.push_back(c);
+        if (cpus.empty())
+            return;
+
+        cpu_set_t one;
+        CPU_ZERO(&one);
+        CPU_SET(cpus[index % cpus.size()], &one);
+        pthread_setaffinity_np(pthread_self(), sizeof(one), &one);
+#else
+        (void)index;
+#endif
+    }
+}
+
+// MARK: Construction
+ThreadPool::ThreadPool(int numThreads, Affinity affinity)
+{
+    if (numThreads <= 0)
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    queues.reserve(numThreads);
+    for (int i = 0; i < numThreads; ++i)
+        queues.push_back(std::make_unique<Queue>());
+
+    workers.reserve(numThreads - 1);
+    for (int i = 1; i < numThreads; ++i)
+        workers.emplace_back(&ThreadPool::workerLoop, this, i, affinity);
+}
+
+ThreadPool::~ThreadPool()
+{
+    stopping.store(true);
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        wake.notify_all();
+    }
+    for (auto& t : workers)
+        t.join();
+}
+
+ThreadPool& ThreadPool::shared()
+{
+    static ThreadPool& pool = []() -> ThreadPool& {
+        SharedConfig& config = sharedConfig();
+        std::lock_guard<std::mutex> lock(config.mutex);
+        config.created = true;
+        static ThreadPool instance(config.threads, config.affinity);
+        return instance;
+    }();
+    return pool;
+}
+
+bool ThreadPool::configureShared(int numThreads, Affinity affinity)
+{
+    SharedConfig& config = sharedConfig();
+    std::lock_guard<std::mutex> lock(config.mutex);
+    if (config.created)
+        return false;
+    config.threads  = numThreads;
+    config.affinity = affinity;
+    return true;
+}
+
+// MARK: Parallel for
+void ThreadPool::parallelFor(int count, int minChunk, RangeFn fn)
+{
+    if (count <= 0) return;
+
+    int chunks = std::min(size() * CHUNKS_PER_THREAD, count / std::max(1, minChunk));
+    if (chunks <= 1 || size() == 1)
+    {
+        fn(0, count);
+        return;
+    }
+
+    ForJob job{ &fn, count, chunks, { chunks - 1 } };
+    push(&ThreadPool::runChunk, &job, 1, chunks - 1);
+
+    // Caller takes chunk 0, then helps with whatever is still queued
+    int begin, end;
+    chunkRange(count, chunks, 0, begin, end);
+    fn(begin, end);
+    helpUntil(job.remaining);
+}
+
+void ThreadPool::runChunk(void* ctx, int index)
+{
+    ForJob& job = *static_cast<ForJob*>(ctx);
+    int begin, end;
+    chunkRange(job.count, job.chunks, index, begin, end);
+    (*job.fn)(begin, end);
+    job.remaining.fetch_sub(1, std::memory_order_release);   // last touch: job may be gone after this
+}
+
+// MARK: Task graph
+void ThreadPool::run(TaskGraph& graph)
+{
+    const int n = graph.size();
+    if (n == 0) return;
+
+    if (graph.pendingSize < n)
+    {
+        graph.pending.reset(new std::atomic<int>[n]);
+        graph.pendingSize = n;
+    }
+    for (int i = 0; i < n; ++i)
+        graph.pending[i].store(graph.depCount[i], std::memory_order_relaxed);
+    graph.remaining.store(n);
+    graph.pool = this;
+
+    // Reverse order, so this thread (popping newest first) starts with the
+    // first task added
+    for (int i = n - 1; i >= 0; --i)
+        if (graph.depCount[i] == 0)
+            push(&ThreadPool::runGraphTask, &graph, i, 1);
+    helpUntil(graph.remaining);
+}
+
+void ThreadPool::runGraphTask(void* ctx, int index)
+{
+    TaskGraph& graph = *static_cast<TaskGraph*>(ctx);
+    graph.fns[index]();
+    for (int next : graph.successors[index])
+        if (graph.pending[next].fetch_sub(1, std::memory_order_acq_rel) == 1)
+            graph.pool->push(&ThreadPool::runGraphTask, &graph, next, 1);
+    graph.remaining.fetch_sub(1, std::memory_order_release);
+}
+
+TaskGraph::TaskId TaskGraph::add(std::function<void()> fn, std::initializer_list<TaskId> deps)
+{
+    return add(std::move(fn), std::vector<TaskId>(deps));
+}
+
+TaskGraph::TaskId TaskGraph::add(std::function<void()> fn, const std::vector<TaskId>& deps)
+{
+    const TaskId id = size();
+    fns.push_back(std::move(fn));
+    successors.emplace_back();
+    depCount.push_back((int)deps.size());
+    for (TaskId d : deps)
+        successors[d].push_back(id);
+    return id;
+}
+
+void TaskGraph::clear()
+{
+    fns.clear();
+    successors.clear();
+    depCount.clear();
+}
+
+// MARK: Queues
+void ThreadPool::push(void (*invoke)(void*, int), void* ctx, int first, int count)
+{
+    Queue& q = *queues[currentPool == this ? currentQueue : 0];
+    {
+        std::lock_guard<std::mutex> lock(q.mutex);
+        for (int k = 0; k < count; ++k)
+            q.pushBack({ invoke, ctx, first + k });
+    }
+
+    // Pairs with the sleeping/queued check in workerLoop: either the worker
+    // sees the new count, or we see it sleeping and notify under the mutex
+    queued.fetch_add(count);
+    if (sleeping.load() > 0)
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        if (count > 1) wake.notify_all();
+        else           wake.notify_one();
+    }
+}
+
+void ThreadPool::Queue::pushBack(const Task& task)
+{
+    if (count == ring.size())
+    {
+        // Unwrap into twice the space, front at slot 0
+        std::vector<Task> grown(ring.size() * 2);
+        for (std::size_t k = 0; k < count; ++k)
+            grown[k] = ring[(head + k) & (ring.size() - 1)];
+        ring.swap(grown);
+        head = 0;
+    }
+    ring[(head + count) & (ring.size() - 1)] = task;
+    ++count;
+}
+
+/// Own queue newest first, then steal the oldest task of the others,
+/// starting with the next queue so thieves spread over the victims.
+bool ThreadPool::findTask(Task& task)
+{
+    if (queued.load() <= 0) return false;
+
+    const int self = currentPool == this ? currentQueue : 0;
+    const int n    = (int)queues.size();
+    for (int k = 0; k < n; ++k)
+    {
+        Queue& q = *queues[(self + k) % n];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.empty()) continue;
+        task = k == 0 ? q.popBack() : q.popFront();
+        queued.fetch_sub(1);
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::helpUntil(const std::atomic<int>& remaining)
+{
+    while (remaining.load(std::memory_order_acquire) > 0)
+    {
+        Task task;
+        if (findTask(task)) task.invoke(task.ctx, task.index);
+        else                std::this_thread::yield();
+    }
+}
+
+// MARK: Worker
+void ThreadPool::workerLoop(int index, Affinity affinity)
+{
+    currentPool  = this;
+    currentQueue = index;
+    Profiler::setThreadName(("worker " + std::to_string(index)).c_str());
+    if (affinity == Affinity::Compact)
+        pinToCpu(index);
+
+    int idle = 0;
+    while (!stopping.load())
+    {
+        Task task;
+        if (findTask(task))
+        {
+            task.invoke(task.ctx, task.index);
+            idle = 0;
+            continue;
+        }
+        if (++idle < IDLE_SPINS)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        idle = 0;
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleeping.fetch_add(1);
+        wake.wait(lock, [this] { return stopping.load() || queued.load() > 0; });
+        sleeping.fetch_sub(1);
+    }
+}
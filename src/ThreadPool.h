@@ -0,0 +1,191 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+class TaskGraph;
+
+/// @file ThreadPool.h
+/// Work-stealing job system behind every parallel phase of the Cloth solver
+/// and ClothWorld's multi-cloth stepping.
+///
+/// **Model:**
+/// parallelFor(count, fn) splits [0, count) into up to CHUNKS_PER_THREAD
+/// contiguous chunks per thread and returns when every chunk is done. The
+/// calling thread runs the first chunk and then helps with the rest. Chunk
+/// boundaries depend only on count, minChunk and thread count, never on
+/// which thread runs a chunk, so a loop whose iterations are independent
+/// gives the same result on every run.
+///
+/// **Tasks:**
+/// run(graph) executes a TaskGraph: each task starts once the tasks it
+/// depends on have finished. A task may itself call parallelFor.
+///
+/// **Scheduling:**
+/// Each worker owns a task queue; it pushes and pops its own work at the back
+/// (newest first, cache-warm) and steals from the front of the others'
+/// (oldest, usually the biggest pieces). Threads that are not workers, e.g.
+/// the simulation thread, submit through a shared injection queue. Any
+/// thread waiting for its work to finish runs queued tasks meanwhile, so
+/// nested parallelFor calls spread across idle workers instead of running
+/// inline, and never deadlock. Idle workers spin briefly, then sleep.
+///
+/// **Callers:**
+/// Any number of threads may submit at once; they share the workers instead
+/// of queueing behind each other. Several simulations in one process should
+/// therefore use one pool (usually shared()) rather than one pool each: with
+/// k submitting threads at most size() - 1 + k threads are busy, so size
+/// shared() with configureShared() to leave the submitters their cores.
+///
+/// **Allocation:**
+/// parallelFor takes its loop body as a RangeFn, a non-owning reference,
+/// and the queues are rings that only ever grow, so once warmed up the
+/// pool schedules work without touching the heap.
+class ThreadPool
+{
+public:
+    /// Where worker threads may run.
+    enum class Affinity
+    {
+        None,       ///< Leave placement to the OS
+        Compact     ///< Pin worker i to the i-th CPU the process may use (Linux; ignored elsewhere)
+    };
+
+    /// Chunks per thread for parallelFor, so a stalled thread's share can
+    /// be stolen in pieces.
+    static constexpr int CHUNKS_PER_THREAD = 4;
+
+    /// @param numThreads Total threads including the caller. 0 = hardware concurrency.
+    /// @param affinity   Worker placement, see Affinity.
+    explicit ThreadPool(int numThreads = 0, Affinity affinity = Affinity::None);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&)            = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /// Number of threads that share the work (workers + calling thread).
+    int size() const { return (int)workers.size() + 1; }
+
+    /// Non-owning reference to a callable fn(begin, end). Binds to any
+    /// lambda without copying it, where a std::function would heap-allocate
+    /// once the captures outgrow its small buffer. Valid only while the
+    /// callable is (a temporary lives until parallelFor returns).
+    class RangeFn
+    {
+    public:
+        template <class Fn, class = std::enable_if_t<!std::is_same_v<std::decay_t<Fn>, RangeFn>>>
+        RangeFn(Fn&& fn)
+            : object(const_cast<void*>(static_cast<const void*>(std::addressof(fn))))
+            , call([](void* o, int begin, int end) { (*static_cast<std::remove_reference_t<Fn>*>(o))(begin, end); })
+        {}
+
+        void operator()(int begin, int end) const { call(object, begin, end); }
+
+    private:
+        void* object;
+        void (*call)(void*, int, int);
+    };
+
+    /// Run fn(begin, end) over [0, count) split across the pool.
+    /// Loops shorter than 2 * minChunk run inline on the caller.
+    void parallelFor(int count, int minChunk, RangeFn fn);
+
+    /// Run every task of graph once, respecting its dependencies; returns
+    /// when all are done.
+    void run(TaskGraph& graph);
+
+    /// Process-wide pool shared by every Cloth that has no explicit pool.
+    static ThreadPool& shared();
+
+    /// Set the thread count and affinity of shared(). Must be called before
+    /// shared() is first used; returns false (and changes nothing) after.
+    static bool configureShared(int numThreads, Affinity affinity = Affinity::None);
+
+private:
+    /// One schedulable unit: invoke(ctx, index) runs it and reports completion
+    struct Task
+    {
+        void (*invoke)(void* ctx, int index);
+        void* ctx;
+        int   index;
+    };
+
+    /// Queue 0 takes submissions from non-worker threads; queue i is worker i's.
+    /// A ring over a power-of-two vector that doubles when full and never
+    /// shrinks (a std::deque frees and reallocates blocks as it drains).
+    struct Queue
+    {
+        std::mutex        mutex;
+        std::vector<Task> ring = std::vector<Task>(64);
+        std::size_t       head  = 0;   ///< Slot of the front task
+        std::size_t       count = 0;
+
+        bool empty() const { return count == 0; }
+        void pushBack(const Task& task);
+        Task popBack()  { --count; return ring[(head + count) & (ring.size() - 1)]; }
+        Task popFront() { Task t = ring[head]; head = (head + 1) & (ring.size() - 1); --count; return t; }
+    };
+
+    void workerLoop(int index, Affinity affinity);
+    /// Queue tasks invoke(ctx, first) … invoke(ctx, first + count - 1)
+    void push(void (*invoke)(void*, int), void* ctx, int first, int count);
+    bool findTask(Task& task);
+    /// Run queued tasks until remaining reaches 0
+    void helpUntil(const std::atomic<int>& remaining);
+
+    static void runChunk(void* job, int index);
+    static void runGraphTask(void* graph, int index);
+
+    /// Chunk `index` of `numChunks` over [0, count)
+    static void chunkRange(int count, int numChunks, int index, int& begin, int& end)
+    {
+        begin = (int)((long long)count * index / numChunks);
+        end   = (int)((long long)count * (index + 1) / numChunks);
+    }
+
+    std::vector<std::thread>            workers;
+    std::vector<std::unique_ptr<Queue>> queues;   ///< size() entries, see Queue
+
+    std::atomic<int>        queued{ 0 };     ///< Tasks in all queues
+    std::atomic<int>        sleeping{ 0 };   ///< Workers blocked on wake
+    std::mutex              sleepMutex;
+    std::condition_variable wake;            ///< Signals sleeping workers that work was queued
+    std::atomic<bool>       stopping{ false };
+};
+
+/// Tasks with dependencies, executed by ThreadPool::run(). Build it once and
+/// run it as often as needed; a graph must not be changed or run again while
+/// it is running.
+class TaskGraph
+{
+public:
+    using TaskId = int;
+
+    /// Add a task that starts after every task in deps (which must already
+    /// be in the graph) has finished.
+    TaskId add(std::function<void()> fn, std::initializer_list<TaskId> deps = {});
+    TaskId add(std::function<void()> fn, const std::vector<TaskId>& deps);
+
+    void clear();
+    int  size() const { return (int)fns.size(); }
+
+private:
+    friend class ThreadPool;
+
+    std::vector<std::function<void()>> fns;
+    std::vector<std::vector<TaskId>>   successors;
+    std::vector<int>                   depCount;
+
+    // Run state, reset by ThreadPool::run()
+    std::unique_ptr<std::atomic<int>[]> pending;   ///< Unfinished dependencies per task
+    int                                 pendingSize = 0;
+    std::atomic<int>                    remaining{ 0 };
+    ThreadPool*                         pool = nullptr;
+};
@@ -0,0 +1,208 @@
+#include "TriangleBvh.h"
+
+#include <algorithm>
+#include <cfloat>
+
+// MARK: Build
+void TriangleBvh::build(const std::vector<glm::vec3>& vertices, const std::vector<glm::ivec3>& triangles)
+{
+    const int n = (int)triangles.size();
+    tris = triangles;
+    order.resize(n);
+    centroids.resize(n);
+    for (int t = 0; t < n; ++t)
+    {
+        order[t]     = t;
+        centroids[t] = (vertices[tris[t].x] + vertices[tris[t].y] + vertices[tris[t].z]) * (1.f / 3.f);
+    }
+
+    nodes.clear();
+    if (n == 0) return;
+    nodes.reserve(2 * (n / LEAF_SIZE + 1));
+    nodes.push_back({});
+    split(vertices, 0, 0, n);
+}
+
+/// Median split along the longest axis of the centroid bounds. Always
+/// halves the range, so the depth is ceil(log2(n / LEAF_SIZE)) at most and
+/// the fixed traversal stacks cannot overflow.
+void TriangleBvh::split(const std::vector<glm::vec3>& vertices, int index, int begin, int end)
+{
+    nodes[index].first = begin;
+    nodes[index].count = end - begin;
+    leafBounds(vertices, nodes[index]);
+    if (end - begin <= LEAF_SIZE) return;
+
+    glm::vec3 lo(FLT_MAX), hi(-FLT_MAX);
+    for (int t = begin; t < end; ++t)
+    {
+        lo = glm::min(lo, centroids[order[t]]);
+        hi = glm::max(hi, centroids[order[t]]);
+    }
+    glm::vec3 extent = hi - lo;
+    int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+
+    int mid = (begin + end) / 2;
+    std::nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end,
+                     [&](int a, int b) { return centroids[a][axis] < centroids[b][axis]; });
+
+    int left = (int)nodes.size();
+    nodes.push_back({});
+    nodes.push_back({});
+    nodes[index].first = left;
+    nodes[index].count = 0;
+    split(vertices, left,     begin, mid);
+    split(vertices, left + 1, mid,   end);
+}
+
+void TriangleBvh::leafBounds(const std::vector<glm::vec3>& vertices, Node& node) const
+{
+    node.lo = glm::vec3(FLT_MAX);
+    node.hi = glm::vec3(-FLT_MAX);
+    for (int t = node.first; t < node.first + node.count; ++t)
+    {
+        const glm::ivec3& tri = tris[order[t]];
+        for (int v : { tri.x, tri.y, tri.z })
+        {
+            node.lo = glm::min(node.lo, vertices[v]);
+            node.hi = glm::max(node.hi, vertices[v]);
+        }
+    }
+}
+
+// MARK: Refit
+void TriangleBvh::refit(const std::vector<glm::vec3>& vertices)
+{
+    for (int i = (int)nodes.size() - 1; i >= 0; --i)
+    {
+        if (nodes[i].count > 0) leafBounds(vertices, nodes[i]);
+        else                    refitInner(i);
+    }
+}
+
+void TriangleBvh::refit(const std::vector<glm::vec3>& from, const std::vector<glm::vec3>& to, float pad)
+{
+    for (int i = (int)nodes.size() - 1; i >= 0; --i)
+    {
+        Node& node = nodes[i];
+        if (node.count == 0) { refitInner(i); continue; }
+
+        Node swept = node;
+        leafBounds(from, node);
+        leafBounds(to, swept);
+        node.lo = glm::min(node.lo, swept.lo) - glm::vec3(pad);
+        node.hi = glm::max(node.hi, swept.hi) + glm::vec3(pad);
+    }
+}
+
+void TriangleBvh::refitInner(int index)
+{
+    Node&       node = nodes[index];
+    const Node& l    = nodes[node.first];
+    const Node& r    = nodes[node.first + 1];
+    node.lo = glm::min(l.lo, r.lo);
+    node.hi = glm::max(l.hi, r.hi);
+}
+
+// MARK: Queries
+float TriangleBvh::boxDistSq(const Node& node, const glm::vec3& p)
+{
+    glm::vec3 d = glm::max(glm::max(node.lo - p, p - node.hi), glm::vec3(0.f));
+    return glm::dot(d, d);
+}
+
+/// Depth-first, nearer child first, pruning boxes farther than the best hit
+/// so far (initially maxDist). The search radius shrinks as hits are found,
+/// so most of the tree is never visited.
+bool TriangleBvh::closestPoint(const std::vector<glm::vec3>& vertices, const glm::vec3& p,
+                               float maxDist, Hit& hit) const
+{
+    if (nodes.empty()) return false;
+
+    float bestSq = maxDist * maxDist;
+    bool  found  = false;
+
+    int stack[64];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0)
+    {
+        const Node& node = nodes[stack[--top]];
+        if (boxDistSq(node, p) >= bestSq) continue;
+
+        if (node.count > 0)
+        {
+            for (int e = node.first; e < node.first + node.count; ++e)
+            {
+                const glm::ivec3& tri = tris[order[e]];
+                glm::vec3 q   = closestPointOnTriangle(p, vertices[tri.x], vertices[tri.y], vertices[tri.z]);
+                glm::vec3 d   = p - q;
+                float     dSq = glm::dot(d, d);
+                if (dSq < bestSq)
+                {
+                    bestSq       = dSq;
+                    hit.point    = q;
+                    hit.triangle = order[e];
+                    hit.distSq   = dSq;
+                    found        = true;
+                }
+            }
+            continue;
+        }
+
+        // Push the farther child first so the nearer one is searched first
+        int   l  = node.first, r = node.first + 1;
+        float dl = boxDistSq(nodes[l], p);
+        float dr = boxDistSq(nodes[r], p);
+        if (dl < dr) std::swap(l, r);
+        stack[top++] = l;
+        stack[top++] = r;
+    }
+    return found;
+}
+
+glm::vec3 TriangleBvh::closestPointOnTriangle(const glm::vec3& p, const glm::vec3& a,
+                                              const glm::vec3& b, const glm::vec3& c)
+{
+    glm::vec3 ab = b - a;
+    glm::vec3 ac = c - a;
+    glm::vec3 ap = p - a;
+
+    // Vertex region A
+    float d1 = glm::dot(ab, ap);
+    float d2 = glm::dot(ac, ap);
+    if (d1 <= 0.f && d2 <= 0.f) return a;
+
+    // Vertex region B
+    glm::vec3 bp = p - b;
+    float d3 = glm::dot(ab, bp);
+    float d4 = glm::dot(ac, bp);
+    if (d3 >= 0.f && d4 <= d3) return b;
+
+    // Edge region AB
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.f && d1 >= 0.f && d3 <= 0.f)
+        return a + ab * (d1 / (d1 - d3));
+
+    // Vertex region C
+    glm::vec3 cp = p - c;
+    float d5 = glm::dot(ab, cp);
+    float d6 = glm::dot(ac, cp);
+    if (d6 >= 0.f && d5 <= d6) return c;
+
+    // Edge region AC
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.f && d2 >= 0.f && d6 <= 0.f)
+        return a + ac * (d2 / (d2 - d6));
+
+    // Edge region BC
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.f && (d4 - d3) >= 0.f && (d5 - d6) >= 0.f)
+        return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+    // Face region (a degenerate triangle falls through to here with zero area)
+    float area = va + vb + vc;
+    if (area <= 0.f) return a;
+    float denom = 1.f / area;
+    return a + ab * (vb * denom) + ac * (vc * denom);
+}
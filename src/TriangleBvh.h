@@ -0,0 +1,122 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+/// @file TriangleBvh.h
+/// Bounding volume hierarchy over a triangle mesh, used by MeshCollider.
+///
+/// **Layout:**
+/// Nodes live in one flat array with the root at index 0. An inner node's
+/// children are adjacent (`first`, `first + 1`) and always stored after it;
+/// a leaf covers triangles[first .. first + count) of the reordered
+/// triangle list (at most LEAF_SIZE per leaf).
+///
+/// **Build:** top-down, splitting each node at the median centroid along the
+/// longest axis of its centroid bounds (std::nth_element, O(n log n)).
+///
+/// **Refit:** when the mesh deforms but keeps its topology, node bounds are
+/// recomputed bottom-up by one reverse sweep over the nodes (children come
+/// after parents), O(n) and no allocation. The tree quality degrades slowly
+/// under large deformation; call build() again if queries get slow.
+///
+/// **Queries:** closestPoint() is a best-first traversal with a shrinking
+/// search radius, so it touches O(log n) nodes for a typical cloth particle.
+/// All queries are const and keep their stack on the call stack, so they can
+/// run from many threads at once.
+class TriangleBvh
+{
+public:
+    static constexpr int LEAF_SIZE = 4;
+
+    /// Result of closestPoint()
+    struct Hit
+    {
+        glm::vec3 point;     ///< Closest point on the mesh
+        int       triangle;  ///< Index into the triangles passed to build()
+        float     distSq;    ///< |query - point|²
+    };
+
+    /// Build the tree. `triangles` holds three vertex indices per triangle.
+    void build(const std::vector<glm::vec3>& vertices, const std::vector<glm::ivec3>& triangles);
+
+    /// Recompute node bounds for moved vertices (same topology as build()).
+    void refit(const std::vector<glm::vec3>& vertices);
+
+    /// Refit to swept bounds: each leaf covers its triangles at both `from`
+    /// and `to` (hence their whole linear motion), grown by `pad`. Used as
+    /// the broadphase for continuous collision over a step.
+    void refit(const std::vector<glm::vec3>& from, const std::vector<glm::vec3>& to, float pad);
+
+    /// Closest point on the mesh to p, if any lies within maxDist.
+    /// `vertices` must be those of the last build() or refit().
+    bool closestPoint(const std::vector<glm::vec3>& vertices, const glm::vec3& p,
+                      float maxDist, Hit& hit) const;
+
+    /// Calls fn(triangle) for every triangle whose leaf bounds overlap [lo, hi].
+    template <typename Fn>
+    void forEachOverlap(const glm::vec3& lo, const glm::vec3& hi, Fn&& fn) const
+    {
+        if (nodes.empty()) return;
+        int stack[64];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0)
+        {
+            const Node& node = nodes[stack[--top]];
+            if (node.hi.x < lo.x || node.hi.y < lo.y || node.hi.z < lo.z ||
+                node.lo.x > hi.x || node.lo.y > hi.y || node.lo.z > hi.z)
+                continue;
+            if (node.count > 0)
+            {
+                for (int t = node.first; t < node.first + node.count; ++t)
+                    fn(order[t]);
+                continue;
+            }
+            stack[top++] = node.first;
+            stack[top++] = node.first + 1;
+        }
+    }
+
+    /// Bounds of the whole tree (the root box); false if it is empty.
+    bool bounds(glm::vec3& lo, glm::vec3& hi) const
+    {
+        if (nodes.empty()) return false;
+        lo = nodes[0].lo;
+        hi = nodes[0].hi;
+        return true;
+    }
+
+    int nodeCount() const { return (int)nodes.size(); }
+    int triangleCount() const { return (int)order.size(); }
+
+    /// Closest point to p on triangle (a, b, c) (Ericson, Real-Time Collision
+    /// Detection §5.1.5: Voronoi-region tests, no square roots).
+    static glm::vec3 closestPointOnTriangle(const glm::vec3& p, const glm::vec3& a,
+                                            const glm::vec3& b, const glm::vec3& c);
+
+private:
+    struct Node
+    {
+        glm::vec3 lo, hi;  ///< Bounds
+        int       first;   ///< Leaf: first entry in order; inner: left child
+        int       count;   ///< Triangles in a leaf, 0 for an inner node
+    };
+
+    /// Recursively split order[begin, end) into node `index`.
+    void split(const std::vector<glm::vec3>& vertices, int index, int begin, int end);
+
+    /// Bounds of the triangles in a leaf.
+    void leafBounds(const std::vector<glm::vec3>& vertices, Node& node) const;
+
+    /// Bottom-up pass: inner node bounds from their children.
+    void refitInner(int index);
+
+    /// Squared distance from p to a node's box (0 inside).
+    static float boxDistSq(const Node& node, const glm::vec3& p);
+
+    std::vector<Node>       nodes;
+    std::vector<int>        order;      ///< Triangle indices in leaf order
+    std::vector<glm::ivec3> tris;       ///< Copy of the triangles, indexed like build()'s input
+    std::vector<glm::vec3>  centroids;  ///< Build scratch
+};
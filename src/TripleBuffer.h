@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+
+/// @file TripleBuffer.h
+/// Lock-free single-producer / single-consumer triple buffer.
+///
+/// **Model:**
+/// Three slots: the producer owns one (writeBuffer()), the consumer owns one
+/// (readBuffer()), and the third holds the most recently published value.
+/// publish() and acquire() swap the caller's slot with the middle one in a
+/// single atomic exchange, so neither side ever blocks or sees a value that
+/// is still being written. Values the consumer never acquired are dropped.
+///
+/// Slots are reused, so a T with vectors keeps its capacity across frames.
+template<typename T>
+class TripleBuffer
+{
+public:
+    /// Producer: slot to fill before the next publish().
+    T& writeBuffer() { return slots[writeIndex]; }
+
+    /// Producer: hand the write slot to the consumer and take a free one.
+    void publish()
+    {
+        writeIndex = middle.exchange(writeIndex | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    /// Consumer: take the newest published slot, if there is one since the
+    /// last acquire(). Returns false (and keeps readBuffer()) otherwise.
+    bool acquire()
+    {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH))
+            return false;
+        readIndex = middle.exchange(readIndex, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+
+    /// Consumer: slot obtained by the last successful acquire().
+    const T& readBuffer() const { return slots[readIndex]; }
+
+private:
+    static constexpr int INDEX_MASK = 3;
+    static constexpr int FRESH      = 4;   ///< Middle slot holds an unread value
+
+    T                slots[3];
+    std::atomic<int> middle{ 1 };
+    int              writeIndex = 0;   ///< Producer-only
+    int              readIndex  = 2;   ///< Consumer-only
+};
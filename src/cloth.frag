@@ -1,9 +1,9 @@
 #version 330 core
-out vec4 FragColor;
+flat in vec3 vColor;
 
-uniform vec3 uColor;
+out vec4 FragColor;
 
 void main()
 {
-    FragColor = vec4(uColor, 1.0);
+    FragColor = vec4(vColor, 1.0);
 }
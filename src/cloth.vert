@@ -1,11 +1,26 @@
 #version 330 core
 layout(location = 0) in vec3 aPos;
+layout(location = 2) in float aPinned;   // 1 for pinned particles, else 0
+
+// Camera and light, shared by every program (SceneUniforms.h)
+layout(std140) uniform Scene
+{
+    mat4 uMVP;
+    mat4 uModel;
+    mat4 uNormalMatrix;   // transpose(inverse(uModel))
+    vec4 uViewPos;
+    vec4 uLightPos;
+};
 
-uniform mat4 uMVP;
 uniform float uPointSize;
+uniform vec3 uColor;         // Free particles
+uniform vec3 uPinnedColor;   // Pinned particles
+
+flat out vec3 vColor;
 
 void main()
 {
-    gl_Position = uMVP * vec4(aPos, 1.0);
+    gl_Position  = uMVP * vec4(aPos, 1.0);
     gl_PointSize = uPointSize;
+    vColor       = aPinned > 0.5 ? uPinnedColor : uColor;
 }
@@ -5,16 +5,29 @@
 #include "imgui_impl_glfw.h"
 #include "imgui_impl_opengl3.h"
 
+#include "AllocCounter.h"
 #include "Cloth.h"
+#include "ClothCache.h"
+#include "ClothLod.h"
+#include "ClothRenderer.h"
+#include "ClothWorld.h"
+#include "GpuCloth.h"
+#include "GpuTimer.h"
+#include "Profiler.h"
+#include "SceneUniforms.h"
 #include "Shader.h"
+#include "SimulationThread.h"
 #include "Constants.h"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
 #include <iostream>
-#include <vector>
+#include <memory>
 
 // ── Callbacks ────────────────────────────────────────────────────────────────
 void framebuffer_size_callback(GLFWwindow* /*window*/, int width, int height)
@@ -36,13 +49,18 @@ int main()
         std::cerr << "Failed to initialize GLFW\n";
         return -1;
     }
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 
-    GLFWwindow* window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT,
-                                          WINDOW_TITLE, nullptr, nullptr);
+    // 4.3 enables the compute backend (GpuCloth); 3.3 is the baseline
+    GLFWwindow* window = nullptr;
+    const int glVersions[][2] = { { 4, 3 }, { 3, 3 } };
+    for (const auto& version : glVersions) {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, version[0]);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, version[1]);
+        window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, WINDOW_TITLE, nullptr, nullptr);
+        if (window) break;
+    }
     if (!window) {
         std::cerr << "Failed to create GLFW window\n";
         glfwTerminate();
@@ -61,6 +79,8 @@ int main()
     }
     std::cout << "OpenGL "  << glGetString(GL_VERSION)  << "\n";
     std::cout << "Renderer: " << glGetString(GL_RENDERER) << "\n";
+    const bool gpuSupported = GpuCloth::supported();
+    std::cout << (gpuSupported ? "✓" : "✗") << " Compute shaders (GPU cloth backend)\n";
 
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_PROGRAM_POINT_SIZE); // lets the shader set gl_PointSize
@@ -74,64 +94,17 @@ int main()
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL3_Init(GLSL_VERSION);
 
-    // ── Cloth ─────────────────────────────────────────────────────────────────
-    Cloth cloth(CLOTH_ROWS, CLOTH_COLS, CLOTH_SPACING);
-
-    // ── GPU buffers for cloth mesh ───────────────────────────────────
-    // Cloth VAO/VBO/EBO — triangulated mesh + points
-    GLuint clothVAO, clothVBO, clothEBO;
-    glGenVertexArrays(1, &clothVAO);
-    glGenBuffers(1, &clothVBO);
-    glGenBuffers(1, &clothEBO);
-
-    // Generate indices for the cloth mesh
-    // Each quad (r, c) becomes two triangles (CCW winding)
-    std::vector<unsigned int> indices;
-    indices.reserve((CLOTH_ROWS - 1) * (CLOTH_COLS - 1) * 6);
-    for (int r = 0; r < CLOTH_ROWS - 1; ++r) {
-        for (int c = 0; c < CLOTH_COLS - 1; ++c) {
-            auto idx = [](int row, int col) { return row * CLOTH_COLS + col; };
-            // Triangle 1: (r, c), (r+1, c), (r, c+1)
-            indices.push_back(idx(r,     c));
-            indices.push_back(idx(r + 1, c));
-            indices.push_back(idx(r,     c + 1));
-            // Triangle 2: (r+1, c), (r+1, c+1), (r, c+1)
-            indices.push_back(idx(r + 1, c));
-            indices.push_back(idx(r + 1, c + 1));
-            indices.push_back(idx(r,     c + 1));
-        }
-    }
-    int indexCount = (int)indices.size();
-
-    // Set up cloth VAO/VBO/EBO with interleaved position + normal
-    glBindVertexArray(clothVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, clothVBO);
-    // Allocate for position + normal (6 floats per vertex), GL_DYNAMIC_DRAW for per-frame updates
-    glBufferData(GL_ARRAY_BUFFER, CLOTH_ROWS * CLOTH_COLS * 6 * sizeof(float), nullptr, GL_DYNAMIC_DRAW);
-
-    // Attribute 0: position (3 floats, stride=24, offset=0)
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    // Attribute 1: normal (3 floats, stride=24, offset=12)
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, clothEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
-
-    glBindVertexArray(0);
-
-    // Pinned VAO/VBO — separate small buffer, never more than a handful of points
-    GLuint pinnedVAO, pinnedVBO;
-    glGenVertexArrays(1, &pinnedVAO);
-    glGenBuffers(1, &pinnedVBO);
-    glBindVertexArray(pinnedVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, pinnedVBO);
-    glBufferData(GL_ARRAY_BUFFER, CLOTH_ROWS * CLOTH_COLS * 3 * sizeof(float), nullptr, GL_DYNAMIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glBindVertexArray(0);
+    // ── Cloths ────────────────────────────────────────────────────────────────
+    // Cloth 0 is the main cloth; the "Flags" slider adds small ones behind it.
+    // Owned by the simulation thread once started; the UI talks to it via post()
+    ClothWorld world;
+    world.add(CLOTH_ROWS, CLOTH_COLS, CLOTH_SPACING);
+    SimulationThread sim(world, DEFAULT_DELTA_TIME);
+
+    // ── GPU buffers for cloth meshes ─────────────────────────────────────────
+    // Sized from the snapshot's cloths; upload() rebuilds them on a change
+    auto renderer = std::make_unique<ClothRenderer>();
+    renderer->resize(sim.current());
 
     // ── Shaders ──────────────────────────────────────────────────────────────
     Shader meshShader("mesh.vert", "mesh.frag");   // Phong shading for mesh
@@ -143,6 +116,18 @@ int main()
     }
     std::cout << "Shaders initialized successfully\n";
 
+    // Camera and light live in one uniform buffer shared by every program;
+    // the colours never change, so they are set once here
+    SceneUniforms sceneUniforms;
+    for (const Shader* shader : { &meshShader, &normalWSShader, &particleShader })
+        shader->bindUniformBlock(SceneUniforms::BLOCK_NAME, SceneUniforms::BINDING);
+    meshShader.use();
+    meshShader.setVec3("uColor", DEFAULT_CLOTH_COLOR);
+    particleShader.use();
+    particleShader.setVec3("uColor", PARTICLE_COLOR);
+    particleShader.setVec3("uPinnedColor", PINNED_PARTICLE_COLOR);
+    glUseProgram(0);
+
     // ── Camera / projection ──────────────────────────────────────────────────
     // Simple fixed camera looking at the cloth from a slight angle.
     // In Phase 4 we'll add proper camera controls.
@@ -155,9 +140,7 @@ int main()
     glm::vec3 cameraUp = DEFAULT_CAMERA_UP;
     glm::vec3 lightPos = DEFAULT_LIGHT_POS;
 
-    glm::mat4 view = glm::lookAt(cameraPos,cameraTarget, cameraUp);
     glm::mat4 model = glm::mat4(1.f);
-    glm::mat4 MVP   = proj * view * model;
 
     // ── Simulation state ─────────────────────────────────────────────────────
     bool  simRunning  = true;
@@ -168,180 +151,453 @@ int main()
     float particleSize = DEFAULT_POINT_SIZE;
     float bgColor[3]  = { 0.1f, 0.1f, 0.1f };
     float deltaTime          = DEFAULT_DELTA_TIME;
-
-    double lastTime = glfwGetTime();
+    int   pendingRows = sim.current().cloths[0].rows;   // Resolution sliders, applied on click
+    int   pendingCols = sim.current().cloths[0].cols;
+    int   flagCount   = 0;
+    bool  autoLod     = false;                 // Pick each cloth's LOD level from its screen size
+    int   manualLod   = 0;
+    std::vector<int> lodRequested;             // Level posted per cloth, so it is sent once
+    ClothParams params = sim.current().cloths[0].params; // UI copy, sent to every cloth on edit
+    bool  floorEnabled = false;                // Ground plane collider
+    float floorHeight  = 0.f;
+
+    // GPU backend: replaces cloth 0 while on; the sim thread is paused then
+    std::unique_ptr<GpuCloth> gpu;
+    float gpuAccumulator = 0.f;
+    auto makeGpuCloth = [&](int rows, int cols) {
+        const float width = CLOTH_SPACING * (CLOTH_COLS - 1);
+        Cloth seed(rows, cols, width / (cols - 1));
+        seed.setParams(params);
+        if (floorEnabled) seed.colliders.planes.push_back({ { 0.f, 1.f, 0.f }, floorHeight });
+        gpu = std::make_unique<GpuCloth>(seed);
+        if (!gpu->valid()) gpu.reset();
+        gpuAccumulator = 0.f;
+    };
+
+    // Cache playback: frames come from a ClothCache file, nothing is simulated
+    ClothCacheReader cache;
+    bool  playback    = false;
+    bool  playing     = true;
+    int   playFrame   = 0;
+    float playTime    = 0.f;                   // Seconds since the cache's first frame
+    char  cachePath[256] = "cloth.cache";
+
+    // Profiler: per-frame zone histories, GPU timer queries, trace capture
+    auto  gpuTimer = std::make_unique<GpuTimer>();
+    int   traceFrames = 120;
+    char  tracePath[256] = "clothsim.trace.json";
+    Profiler::setThreadName("render");
+    Profiler::setEnabled(true);
+
+    // Allocation check: once the simulation has settled (WorldSnapshot::steady)
+    // the acquire, upload and draw of a CPU-simulated frame allocate nothing
+    constexpr int ALLOC_WARMUP_FRAMES = 3;
+    int           steadyFrames   = 0;
+    std::uint64_t frameAllocs    = 0;   // Acquire, upload and draw of the last frame
+    auto          lastUploadMode = renderer->getUploadMode();
+
+    // The sim thread only runs while it is the one producing frames
+    auto updateSimRunning = [&]() { sim.setRunning(simRunning && !gpu && !playback); };
+
+    sim.start();
 
     // ── Render loop ──────────────────────────────────────────────────────────
     while (!glfwWindowShouldClose(window))
     {
         glfwPollEvents();
 
-        // Delta time
-        double now   = glfwGetTime();
-        float  delta = (float)(now - lastTime);
-        lastTime     = now;
-
-        // ── Simulate ─────────────────────────────────────────────────────────
-        if (simRunning)
-            cloth.update(deltaTime);
-
-        // ── Upload particle positions and compute normals to GPU ────────────────
-        const auto& particles = cloth.getParticles();
-
-        // Compute vertex normals by accumulating face normals
-        std::vector<glm::vec3> normals(particles.size(), glm::vec3(0.f));
-        for (int i = 0; i < indexCount; i += 3) {
-            auto& p0 = particles[indices[i]];
-            auto& p1 = particles[indices[i+1]];
-            auto& p2 = particles[indices[i+2]];
-            glm::vec3 n = glm::cross(p1.position - p0.position, p2.position - p0.position);
-            normals[indices[i]]   += n;
-            normals[indices[i+1]] += n;
-            normals[indices[i+2]] += n;
+        // ── Simulate (fixed-step, on the sim thread) ─────────────────────────
+        AllocCounter::Scope allocs;
+        {
+            PROFILE_SCOPE("acquire");
+            sim.acquire();
         }
-        for (auto& n : normals) {
-            if (glm::length(n) > 0.0001f)
-                n = glm::normalize(n);
+        const WorldSnapshot& snap = sim.current();
+        const ClothSnapshot& primary = snap.cloths[0];
+
+        // ── Simulate on the GPU (fixed step, on this thread) ─────────────────
+        if (gpu && simRunning) {
+            PROFILE_SCOPE("gpu sim");
+            GPU_PROFILE_SCOPE(*gpuTimer, "GPU compute");
+            gpuAccumulator += io.DeltaTime;
+            int steps = 0;
+            for (; gpuAccumulator >= deltaTime && steps < SimulationThread::MAX_SUBSTEPS; ++steps) {
+                gpu->update(deltaTime);
+                gpuAccumulator -= deltaTime;
+            }
+            if (steps == SimulationThread::MAX_SUBSTEPS) gpuAccumulator = 0.f;   // Can't keep up: drop time
         }
 
-        // Build interleaved position + normal data for mesh rendering
-        std::vector<float> meshData;
-        meshData.reserve(particles.size() * 6);
-        for (int i = 0; i < (int)particles.size(); ++i) {
-            meshData.push_back(particles[i].position.x);
-            meshData.push_back(particles[i].position.y);
-            meshData.push_back(particles[i].position.z);
-            meshData.push_back(normals[i].x);
-            meshData.push_back(normals[i].y);
-            meshData.push_back(normals[i].z);
+        // ── Playback: advance through the cache in real time, looping ────────
+        if (playback && playing && cache.getFrameCount() > 1) {
+            const float t0 = cache.getFrameTime(0);
+            playTime += io.DeltaTime;
+            if (playTime > cache.getFrameTime(cache.getFrameCount() - 1) - t0) {
+                playTime  = 0.f;
+                playFrame = 0;
+            }
+            while (playFrame + 1 < cache.getFrameCount() && cache.getFrameTime(playFrame + 1) - t0 <= playTime)
+                ++playFrame;
         }
 
-        glBindBuffer(GL_ARRAY_BUFFER, clothVBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, meshData.size() * sizeof(float), meshData.data());
+        // ── Upload particle positions (normals are computed in mesh.vert) ────
+        {
+            PROFILE_SCOPE("upload");
+            if (playback) renderer->upload(cache, playFrame);
+            else          renderer->upload(sim.previous(), snap, sim.interpolationAlpha());
+        }
+        frameAllocs = allocs.count();
 
-        // Collect pinned particles for separate rendering
-        std::vector<float> pinnedData;
-        for (const auto& p : particles) {
-            if (p.pinned) {
-                pinnedData.push_back(p.position.x);
-                pinnedData.push_back(p.position.y);
-                pinnedData.push_back(p.position.z);
+        // ── ImGui ─────────────────────────────────────────────────────────────
+        {
+            PROFILE_SCOPE("ui");
+            ImGui_ImplOpenGL3_NewFrame();
+            ImGui_ImplGlfw_NewFrame();
+            ImGui::NewFrame();
+
+            ImGui::Begin("Cloth Simulation");
+
+            ImGui::Text("FPS: %.1f", io.Framerate);
+            ImGui::Separator();
+
+            ImGui::Text("Simulation");
+            if (ImGui::Checkbox("Running", &simRunning))
+                updateSimRunning();
+            if (ImGui::Button("Reset")) {
+                sim.postAll([](Cloth& c) { c.reset(); });
+                if (gpu) makeGpuCloth(gpu->getRows(), gpu->getCols());
+            }
+            ImGui::SameLine();
+            bool gpuEnabled = gpu != nullptr;
+            ImGui::BeginDisabled(!gpuSupported || playback);
+            if (ImGui::Checkbox("GPU (compute)", &gpuEnabled)) {
+                if (gpuEnabled) makeGpuCloth(primary.rows, primary.cols);
+                else            gpu.reset();
+                updateSimRunning();
+            }
+            ImGui::EndDisabled();
+            if (gpu)
+                ImGui::Text("GPU: %d particles, %d springs, t = %.1f s (mass-spring only)",
+                            gpu->getParticleCount(), gpu->getSpringCount(), gpu->getSimTime());
+            if (ImGui::SliderFloat("Delta Time (ms)", &deltaTime, 0.001f, 0.033f, "%.4f"))
+                sim.setTimeStep(deltaTime);
+            ImGui::Text("Sim step: %.2f ms, t = %.1f s", snap.stepMs, snap.simTime);
+            if (ImGui::Checkbox("Sleep settled tiles", &params.sleepEnabled))
+                sim.postAll([on = params.sleepEnabled](Cloth& c) { c.sleepEnabled = on; });
+            if (params.sleepEnabled) {
+                int asleep = 0, tiles = 0;
+                for (const ClothSnapshot& c : snap.cloths) {
+                    asleep += c.sleepingTiles;
+                    tiles  += c.tileCount;
+                }
+                ImGui::SameLine();
+                ImGui::Text("%d / %d asleep", asleep, tiles);
+            }
+            ImGui::Separator();
+
+            ImGui::Text("Resolution");
+            ImGui::SliderInt("Rows", &pendingRows, 2, 256);
+            ImGui::SliderInt("Cols", &pendingCols, 2, 256);
+            if (ImGui::Button("Apply")) {
+                // Keep the cloth's width constant: finer grids get shorter springs
+                float width = CLOTH_SPACING * (CLOTH_COLS - 1);
+                sim.post([r = pendingRows, c = pendingCols, width](ClothWorld& w) {
+                    w[0].resize(r, c, width / (c - 1));
+                });
+                if (gpu) makeGpuCloth(pendingRows, pendingCols);
+            }
+            ImGui::SameLine();
+            ImGui::Text("%d x %d", primary.rows, primary.cols);
+            if (ImGui::SliderInt("Flags", &flagCount, 0, MAX_FLAGS)) {
+                // Rows of small cloths behind the main one, sharing its parameters
+                sim.post([n = flagCount](ClothWorld& w) {
+                    const float width = FLAG_SPACING * (FLAG_COLS - 1);
+                    while (w.size() > n + 1) w.remove(w.size() - 1);
+                    for (int k = w.size() - 1; k < n; ++k) {
+                        glm::vec3 origin = { (k % FLAGS_PER_ROW - 0.5f * (FLAGS_PER_ROW - 1)) * width * 1.3f,
+                                             4.f - (k / FLAGS_PER_ROW) * width,
+                                             -3.f };
+                        Cloth& flag = w.add(FLAG_ROWS, FLAG_COLS, FLAG_SPACING, origin);
+                        flag.setParams(w[0].getParams());
+                        flag.colliders = w[0].colliders;
+                    }
+                });
+            }
+            ImGui::Text("%d cloths: %d particles, %d springs", (int)snap.cloths.size(),
+                        snap.particleCount(), snap.springCount());
+            ImGui::Separator();
+
+            ImGui::Text("Level of detail");
+            ImGui::Checkbox("Auto LOD", &autoLod);
+            ImGui::BeginDisabled(autoLod);
+            if (ImGui::SliderInt("LOD level", &manualLod, 0, LOD_MAX_LEVEL))
+                sim.postAll([l = manualLod](Cloth& c) { c.setLodLevel(l); });
+            ImGui::EndDisabled();
+            lodRequested.resize(snap.cloths.size(), -1);
+            if (autoLod && !gpu && !playback) {
+                // Screen width of each cloth: its longer projected top or bottom edge
+                int fbWidth = 0, fbHeight = 0;
+                glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
+                const glm::mat4 lodMVP = proj * glm::lookAt(cameraPos, cameraTarget, cameraUp) * model;
+                for (int k = 0; k < (int)snap.cloths.size(); ++k) {
+                    const ClothSnapshot& c = snap.cloths[k];
+                    auto screen = [&](int g, glm::vec2& out) {
+                        const glm::vec4 p = lodMVP * glm::vec4(glm::make_vec3(&c.positions[g * 3]), 1.f);
+                        out = { p.x / p.w * 0.5f * fbWidth, p.y / p.w * 0.5f * fbHeight };
+                        return p.w > CAMERA_NEAR;
+                    };
+                    glm::vec2 a, b, d, e;
+                    float pixels = 1e9f;   // Behind the camera: keep full detail
+                    if (screen(0, a) & screen(c.cols - 1, b) &
+                        screen((c.rows - 1) * c.cols, d) & screen(c.rows * c.cols - 1, e))
+                        pixels = std::max(glm::length(b - a), glm::length(e - d));
+                    const int level = ClothLod::chooseLevel(c.rows, c.cols, pixels, c.lodLevel);
+                    if (level == c.lodLevel)
+                        lodRequested[k] = -1;
+                    else if (level != lodRequested[k]) {
+                        sim.post([k, level](ClothWorld& w) { if (k < w.size()) w[k].setLodLevel(level); });
+                        lodRequested[k] = level;
+                    }
+                }
+            }
+            {
+                int simulated = 0, displayed = 0;
+                for (const ClothSnapshot& c : snap.cloths) {
+                    simulated += c.simRows * c.simCols;
+                    displayed += c.rows * c.cols;
+                }
+                ImGui::Text("Cloth 0: level %d, %d x %d simulated", primary.lodLevel,
+                            primary.simRows, primary.simCols);
+                ImGui::Text("%d simulated / %d displayed particles", simulated, displayed);
+            }
+            ImGui::Separator();
+
+            ImGui::Text("Camera");
+            ImGui::SliderFloat3("Camera pos", glm::value_ptr(cameraPos), -20.f, 20.f);
+            ImGui::Separator();
+
+            ImGui::Text("Physics");
+            bool edited = false;
+            edited |= ImGui::SliderFloat3("Gravity", glm::value_ptr(params.gravity), -20.f, 20.f);
+            edited |= ImGui::SliderFloat("Stiffness", &params.springStiffness, 1.f, 2000.f);
+            edited |= ImGui::SliderFloat("Bend k", &params.bendStiffness, 0.f, 500.f);
+            edited |= ImGui::SliderFloat("Air damp", &params.airDamping, 0.f, 0.5f);
+            edited |= ImGui::SliderFloat("Spring damp", &params.springDamping, 0.f, 1.f);
+            edited |= ImGui::SliderFloat("Max stretch", &params.maxStretch, 1.f, 1.3f);
+            const char* solverNames[] = { "Mass-spring", "XPBD (small steps)", "Implicit (Baraff-Witkin)" };
+            int solverIndex = (int)params.solverMode;
+            if (ImGui::Combo("Solver", &solverIndex, solverNames, 3)) {
+                params.solverMode = (SolverMode)solverIndex;
+                edited = true;
+            }
+            if (params.solverMode == SolverMode::XPBD)
+                edited |= ImGui::SliderInt("Substeps", &params.xpbdSubsteps, 1, 40);
+            else {
+                edited |= ImGui::SliderInt("Constraint iters", &params.constraintIters, 1, 40);
+                edited |= ImGui::SliderFloat("Constraint tol", &params.constraintTolerance, 0.f, 0.05f, "%.4f");
+                edited |= ImGui::Checkbox("Multigrid stretch", &params.multigridConstraints);
+                ImGui::Text("Constraints: %d / %d sweeps last step", primary.constraintIterations,
+                            params.constraintIters);
+            }
+            if (params.solverMode == SolverMode::Implicit) {
+                edited |= ImGui::SliderInt("PCG max iters", &params.implicitMaxIters, 1, 200);
+                ImGui::Text("PCG: %d iterations last step", primary.implicitIterations);
+            }
+            edited |= ImGui::Checkbox("Wind", &params.windEnabled);
+            ImGui::BeginDisabled(!params.windEnabled);
+            edited |= ImGui::SliderFloat("Wind strength", &params.windStrength, 0.f, 20.f);
+            edited |= ImGui::SliderFloat3("Wind dir", glm::value_ptr(params.windDirection), -1.f, 1.f);
+            ImGui::EndDisabled();
+            ImGui::Separator();
+
+            ImGui::Text("Collisions");
+            bool floorEdited = ImGui::Checkbox("Floor", &floorEnabled);
+            ImGui::BeginDisabled(!floorEnabled);
+            floorEdited |= ImGui::SliderFloat("Floor height", &floorHeight, -2.f, 5.f);
+            ImGui::EndDisabled();
+            if (floorEdited) {
+                sim.postAll([on = floorEnabled, y = floorHeight](Cloth& c) {
+                    c.colliders.planes.clear();
+                    if (on) c.colliders.planes.push_back({ { 0.f, 1.f, 0.f }, y });
+                });
+                if (gpu) {
+                    ColliderSet floor;
+                    if (floorEnabled) floor.planes.push_back({ { 0.f, 1.f, 0.f }, floorHeight });
+                    gpu->setColliders(floor);
+                }
+            }
+            edited |= ImGui::SliderFloat("Thickness", &params.collisionThickness, 0.f, 0.05f, "%.3f");
+            edited |= ImGui::SliderFloat("Friction", &params.collisionFriction, 0.f, 1.f);
+            edited |= ImGui::Checkbox("Continuous (CCD)", &params.continuousCollisions);
+            if (edited) {
+                sim.postAll([p = params](Cloth& c) { c.setParams(p); });
+                if (gpu) gpu->setParams(params);
+            }
+            ImGui::Separator();
+
+            ImGui::Text("Cache playback");
+            ImGui::InputText("Cache file", cachePath, sizeof(cachePath));
+            if (ImGui::Button("Load") && cache.open(cachePath) && cache.getFrameCount() > 0) {
+                playback  = true;
+                playFrame = 0;
+                playTime  = 0.f;
+                gpu.reset();
+                updateSimRunning();
+            }
+            if (playback) {
+                ImGui::SameLine();
+                if (ImGui::Button("Back to simulation")) {
+                    cache.close();
+                    playback = false;
+                    updateSimRunning();
+                }
+            }
+            if (playback) {
+                ImGui::Checkbox("Play", &playing);
+                if (ImGui::SliderInt("Frame", &playFrame, 0, cache.getFrameCount() - 1))
+                    playTime = cache.getFrameTime(playFrame) - cache.getFrameTime(0);
+                ImGui::Text("%d x %d, %d frames, t = %.2f s, %.1f bytes/particle", cache.getRows(),
+                            cache.getCols(), cache.getFrameCount(), cache.getFrameTime(playFrame),
+                            (double)cache.getFrameBytes(playFrame) / cache.getParticleCount());
+            }
+            ImGui::Separator();
+
+            ImGui::Text("Display");
+            ImGui::Checkbox("Show mesh", &showMesh);
+            ImGui::BeginDisabled(!showMesh);
+            ImGui::Checkbox("Wireframe", &wireframe);
+            ImGui::Checkbox("Normal debug", &normalDebugMode);
+            ImGui::EndDisabled();
+            ImGui::Checkbox("Show particles", &showParticles);
+            ImGui::SliderFloat("Particle size", &particleSize, 0.5f, 15.f);
+            ImGui::ColorEdit3("Background", bgColor);
+            if (ImGui::BeginCombo("Upload", ClothRenderer::uploadModeName(renderer->getUploadMode()))) {
+                using Mode = ClothRenderer::UploadMode;
+                for (Mode m : { Mode::BufferSubData, Mode::MapRing, Mode::PersistentRing }) {
+                    ImGui::BeginDisabled(!ClothRenderer::uploadModeSupported(m));
+                    if (ImGui::Selectable(ClothRenderer::uploadModeName(m), renderer->getUploadMode() == m))
+                        renderer->setUploadMode(m);
+                    ImGui::EndDisabled();
+                }
+                ImGui::EndCombo();
+            }
+            ImGui::SliderFloat3("Light pos", glm::value_ptr(lightPos), -10.f, 10.f);
+
+            if (ImGui::CollapsingHeader("Profiler")) {
+                bool profiling = Profiler::enabled();
+                if (ImGui::Checkbox("Enabled", &profiling))
+                    Profiler::setEnabled(profiling);
+                if (!CLOTHSIM_PROFILING) {
+                    ImGui::SameLine();
+                    ImGui::TextDisabled("(compiled out)");
+                }
+                // Per-frame totals of each zone; simulation zones sum every
+                // step (and thread) that ran during the frame
+                for (bool gpuZones : { false, true }) {
+                    ImGui::Text(gpuZones ? "GPU" : "CPU");
+                    for (int z = 0; z < Profiler::getZoneCount(); ++z) {
+                        if (Profiler::isGpuZone(z) != gpuZones || Profiler::getMaxMs(z) <= 0.f) continue;
+                        char overlay[96];
+                        std::snprintf(overlay, sizeof(overlay), "%s: %.2f ms (mean %.2f, max %.2f)",
+                                      Profiler::getZoneName(z), Profiler::getLastMs(z),
+                                      Profiler::getMeanMs(z), Profiler::getMaxMs(z));
+                        ImGui::PushID(z);
+                        ImGui::PlotHistogram("##zone", Profiler::getHistory(z), Profiler::HISTORY,
+                                             Profiler::getHistoryOffset(), overlay, 0.f,
+                                             Profiler::getMaxMs(z), ImVec2(0.f, 36.f));
+                        ImGui::PopID();
+                    }
+                }
+                ImGui::InputText("Trace file", tracePath, sizeof(tracePath));
+                ImGui::SliderInt("Trace frames", &traceFrames, 1, 1000);
+                ImGui::BeginDisabled(!CLOTHSIM_PROFILING || Profiler::isTracing());
+                if (ImGui::Button("Capture trace"))
+                    Profiler::beginTrace(tracePath, traceFrames);
+                ImGui::EndDisabled();
+                if (Profiler::isTracing()) {
+                    ImGui::SameLine();
+                    ImGui::Text("Recording...");
+                }
+                if (CLOTHSIM_ALLOC_COUNTER)
+                    ImGui::Text("Heap allocations: %llu last frame, %llu last sim batch",
+                                (unsigned long long)frameAllocs, (unsigned long long)snap.stepAllocs);
+                else
+                    ImGui::TextDisabled("Heap allocations: (counted in Debug builds only)");
             }
-        }
 
-        glBindBuffer(GL_ARRAY_BUFFER, pinnedVBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, pinnedData.size() * sizeof(float), pinnedData.data());
+            ImGui::End();
+        }
 
-        // ── ImGui ─────────────────────────────────────────────────────────────
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplGlfw_NewFrame();
-        ImGui::NewFrame();
-
-        ImGui::Begin("Cloth Simulation");
-
-        ImGui::Text("FPS: %.1f", io.Framerate);
-        ImGui::Separator();
-
-        ImGui::Text("Simulation");
-        ImGui::Checkbox("Running", &simRunning);
-        if (ImGui::Button("Reset")) cloth.reset();
-        ImGui::SliderFloat("Delta Time (ms)", &deltaTime, 0.001f, 0.033f, "%.4f");
-        ImGui::Separator();
-
-        ImGui::Text("Camera");
-        ImGui::SliderFloat3("Camera pos", glm::value_ptr(cameraPos), -20.f, 20.f);
-        ImGui::Separator();
-
-        ImGui::Text("Physics");
-        ImGui::SliderFloat3("Gravity", glm::value_ptr(cloth.gravity), -20.f, 20.f);
-        ImGui::SliderFloat("Stiffness", &cloth.springStiffness, 1.f, 2000.f);
-        ImGui::SliderFloat("Bend k", &cloth.bendStiffness, 0.f, 500.f);
-        ImGui::SliderFloat("Air damp", &cloth.airDamping, 0.f, 0.5f);
-        ImGui::SliderFloat("Spring damp", &cloth.springDamping, 0.f, 1.f);
-        ImGui::SliderFloat("Max stretch", &cloth.maxStretch, 1.f, 1.3f);
-        ImGui::SliderInt("Constraint iters", &cloth.constraintIters, 1, 40);
-        ImGui::Checkbox("Wind", &cloth.windEnabled);
-        ImGui::BeginDisabled(!cloth.windEnabled);
-        ImGui::SliderFloat("Wind strength", &cloth.windStrength, 0.f, 20.f);
-        ImGui::SliderFloat3("Wind dir", glm::value_ptr(cloth.windDirection), -1.f, 1.f);
-        ImGui::EndDisabled();
-        ImGui::Separator();
-
-        ImGui::Text("Display");
-        ImGui::Checkbox("Show mesh", &showMesh);
-        ImGui::BeginDisabled(!showMesh);
-        ImGui::Checkbox("Wireframe", &wireframe);
-        ImGui::Checkbox("Normal debug", &normalDebugMode);
-        ImGui::EndDisabled();
-        ImGui::Checkbox("Show particles", &showParticles);
-        ImGui::SliderFloat("Particle size", &particleSize, 0.5f, 15.f);
-        ImGui::ColorEdit3("Background", bgColor);
-        ImGui::SliderFloat3("Light pos", glm::value_ptr(lightPos), -10.f, 10.f);
-
-        ImGui::End();
-
-        // Recompute MVP every frame so camera changes take effect immediately
+        // Recompute the camera every frame so changes take effect immediately
         glm::mat4 view = glm::lookAt(cameraPos,cameraTarget, cameraUp);
-        glm::mat4 MVP = proj * view * model;
 
         // ── Render ────────────────────────────────────────────────────────────
+        allocs.restart();
         glClearColor(bgColor[0], bgColor[1], bgColor[2], 1.f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        // Render mesh with Phong shading or normal debug
-        if (showMesh) {
-            if (normalDebugMode) {
-                normalWSShader.use();
-                normalWSShader.setMat4("uMVP", MVP);
-                normalWSShader.setMat4("uModel", model);
-            } else {
-                meshShader.use();
-                meshShader.setMat4("uMVP", MVP);
-                meshShader.setMat4("uModel", model);
-                meshShader.setVec3("uColor", DEFAULT_CLOTH_COLOR);
-                meshShader.setVec3("uLightPos", lightPos);
-                meshShader.setVec3("uViewPos", cameraPos);
+        {
+            PROFILE_SCOPE("draw");
+            sceneUniforms.update(proj * view, model, cameraPos, lightPos);
+
+            // Render mesh with Phong shading or normal debug. In GPU mode only
+            // the GpuCloth is drawn, straight from its simulation buffers.
+            if (showMesh) {
+                GPU_PROFILE_SCOPE(*gpuTimer, "GPU mesh");
+                const Shader& shader = normalDebugMode ? normalWSShader : meshShader;
+                shader.use();
+                if (gpu) gpu->bindGridUniforms(shader);
+                else     renderer->bindGridUniforms(shader);
+                if (wireframe)
+                    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+                if (gpu) gpu->drawMesh();
+                else     renderer->drawMesh();
+                if (wireframe)
+                    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
             }
-            if (wireframe)
-                glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-            glBindVertexArray(clothVAO);
-            glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
-            if (wireframe)
-                glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-        }
 
-        // Render particles
-        if (showParticles) {
-            particleShader.use();
-            particleShader.setMat4("uMVP", MVP);
-            particleShader.setFloat("uPointSize", particleSize);
-            // All particles — white
-            particleShader.setVec3("uColor", glm::vec3(1.f, 1.f, 1.f));
-            glBindVertexArray(clothVAO);
-            glDrawArrays(GL_POINTS, 0, (GLsizei)particles.size());
-
-            // Pinned particles — red, drawn from their own VAO
-            if (!pinnedData.empty()) {
-                particleShader.setVec3("uColor", glm::vec3(1.f, 0.2f, 0.2f));
-                glBindVertexArray(pinnedVAO);
-                glDrawArrays(GL_POINTS, 0, (GLsizei)(pinnedData.size() / 3));
+            // Render particles — one draw for every cloth, pinned ones
+            // coloured by their vertex attribute
+            if (showParticles) {
+                GPU_PROFILE_SCOPE(*gpuTimer, "GPU points");
+                particleShader.use();
+                particleShader.setFloat("uPointSize", particleSize);
+                if (gpu) gpu->drawPoints();
+                else     renderer->drawPoints();
+                glBindVertexArray(0);
             }
-
-            glBindVertexArray(0);
+        }
+        renderer->endFrame();
+        frameAllocs += allocs.count();
+
+        const bool settled = snap.steady && !gpu && !playback && !Profiler::isTracing() &&
+                             renderer->getUploadMode() == lastUploadMode;
+        steadyFrames   = settled ? steadyFrames + 1 : 0;
+        lastUploadMode = renderer->getUploadMode();
+        if (steadyFrames > ALLOC_WARMUP_FRAMES)
+            AllocCounter::expectNone(frameAllocs, "render frame");
+
+        {
+            PROFILE_SCOPE("imgui render");
+            GPU_PROFILE_SCOPE(*gpuTimer, "GPU imgui");
+            ImGui::Render();
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
         }
 
-        ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-
-        glfwSwapBuffers(window);
+        {
+            PROFILE_SCOPE("swap");   // Includes the vsync wait
+            glfwSwapBuffers(window);
+        }
+        gpuTimer->endFrame();
+        Profiler::endFrame();
     }
 
     // ── Cleanup ──────────────────────────────────────────────────────────────
-    glDeleteVertexArrays(1, &clothVAO);
-    glDeleteBuffers(1, &clothVBO);
-    glDeleteBuffers(1, &clothEBO);
-    glDeleteVertexArrays(1, &pinnedVAO);
-    glDeleteBuffers(1, &pinnedVBO);
+    sim.stop();
+    Profiler::endTrace();   // Write a capture cut short by closing the window
+    renderer.reset();   // GL objects must go before the context does
+    gpu.reset();
+    gpuTimer.reset();
     // Shader will be cleaned up by its destructor
 
     ImGui_ImplOpenGL3_Shutdown();
@@ -3,8 +3,16 @@ in vec3 vNormal;
 in vec3 vFragPos;
 
 uniform vec3 uColor;
-uniform vec3 uLightPos;
-uniform vec3 uViewPos;
+
+// Camera and light, shared by every program (SceneUniforms.h)
+layout(std140) uniform Scene
+{
+    mat4 uMVP;
+    mat4 uModel;
+    mat4 uNormalMatrix;   // transpose(inverse(uModel))
+    vec4 uViewPos;
+    vec4 uLightPos;
+};
 
 out vec4 FragColor;
 
@@ -35,8 +43,8 @@ vec3 FresnelPhongLighting(vec3 normal, vec3 lightDir, vec3 halfDir, vec3 viewDir
 void main()
 {
     vec3 N = normalize(gl_FrontFacing ? vNormal : -vNormal);
-    vec3 L = normalize(uLightPos - vFragPos);
-    vec3 V = normalize(uViewPos  - vFragPos);
+    vec3 L = normalize(uLightPos.xyz - vFragPos);
+    vec3 V = normalize(uViewPos.xyz - vFragPos);
     vec3 H  = normalize(L + V);
 
     vec3 col;
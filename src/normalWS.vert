@@ -1,16 +1,54 @@
 #version 330 core
 layout(location = 0) in vec3 aPos;
-layout(location = 1) in vec3 aNormal;
+layout(location = 1) in ivec3 aGrid;   // first vertex, rows, cols of this vertex's cloth
 
-uniform mat4 uMVP;
-uniform mat4 uModel;
+// Camera and light, shared by every program (SceneUniforms.h)
+layout(std140) uniform Scene
+{
+    mat4 uMVP;
+    mat4 uModel;
+    mat4 uNormalMatrix;   // transpose(inverse(uModel))
+    vec4 uViewPos;
+    vec4 uLightPos;
+};
+
+// Cloth positions as a flat float array (uVertexStride texels per particle:
+// 3 from ClothRenderer, 4 from GpuCloth), see ClothRenderer
+uniform samplerBuffer uPositions;
+uniform int uBaseVertex;
+uniform int uVertexStride;
+
+vec3 gridPosition(int r, int c)
+{
+    int t = (uBaseVertex + aGrid.x + r * aGrid.z + c) * uVertexStride;
+    return vec3(texelFetch(uPositions, t).r,
+                texelFetch(uPositions, t + 1).r,
+                texelFetch(uPositions, t + 2).r);
+}
+
+// Finite-difference normal of the grid vertex being shaded: cross of the
+// row and column central differences (one-sided at the border). Matches the
+// CCW winding of the index buffer.
+vec3 gridNormal()
+{
+    int rows = aGrid.y;
+    int cols = aGrid.z;
+    int i = gl_VertexID - uBaseVertex - aGrid.x;
+    int r = i / cols;
+    int c = i - r * cols;
+    vec3 dRow = gridPosition(min(r + 1, rows - 1), c) - gridPosition(max(r - 1, 0), c);
+    vec3 dCol = gridPosition(r, min(c + 1, cols - 1)) - gridPosition(r, max(c - 1, 0));
+    vec3 n    = cross(dRow, dCol);
+    float len = length(n);
+    return len > 1e-8 ? n / len : vec3(0.0, 0.0, 1.0);
+}
 
 out vec3 vNormalWS;
 
 void main()
 {
     gl_Position = uMVP * vec4(aPos, 1.0);
-    // Transform normal to world space using inverse transpose (handles non-uniform scaling)
-    vNormalWS   = mat3(transpose(inverse(uModel))) * aNormal;
+    // Transform normal to world space using the inverse transpose (handles non-uniform scaling)
+    vNormalWS   = mat3(uNormalMatrix) * gridNormal();
 }
 
@@ -0,0 +1,46 @@
+# Round-trip regression test for clothsim_headless, run by CTest:
+#
+#   cmake -DHEADLESS=<exe> -DMODE=<mode> -DARGS="<options>" -DWORK_DIR=<dir>
+#         -P RoundTripTest.cmake
+#
+# checkpoint: 200 steps in one run must write the same OBJ as 100 steps,
+#             --checkpoint, then --restore and 100 more (Cloth::saveState()
+#             promises a bit-for-bit resume).
+# cache:      the last frame of a raw (unquantised) --cache of a 200-step
+#             run, read back with --read-cache, must be the same OBJ as
+#             the run's own output.
+#
+# ARGS are the scene and solver options given to every run.
+
+if(NOT HEADLESS OR NOT MODE OR NOT WORK_DIR)
+    message(FATAL_ERROR "RoundTripTest.cmake needs -DHEADLESS, -DMODE and -DWORK_DIR")
+endif()
+separate_arguments(args UNIX_COMMAND "${ARGS}")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+
+function(run_headless)
+    execute_process(COMMAND "${HEADLESS}" ${args} --quiet ${ARGN} RESULT_VARIABLE rc)
+    if(NOT rc EQUAL 0)
+        message(FATAL_ERROR "clothsim_headless ${ARGS} ${ARGN} failed: ${rc}")
+    endif()
+endfunction()
+
+function(expect_same a b)
+    execute_process(COMMAND "${CMAKE_COMMAND}" -E compare_files "${a}" "${b}" RESULT_VARIABLE rc)
+    if(NOT rc EQUAL 0)
+        message(FATAL_ERROR "${a} and ${b} differ")
+    endif()
+endfunction()
+
+if(MODE STREQUAL "checkpoint")
+    run_headless(--steps 200 --out "${WORK_DIR}/straight.obj")
+    run_headless(--steps 100 --checkpoint "${WORK_DIR}/half.state" --out "${WORK_DIR}/half.obj")
+    run_headless(--restore "${WORK_DIR}/half.state" --steps 100 --out "${WORK_DIR}/resumed.obj")
+    expect_same("${WORK_DIR}/straight.obj" "${WORK_DIR}/resumed.obj")
+elseif(MODE STREQUAL "cache")
+    run_headless(--steps 200 --cache "${WORK_DIR}/run.cache" --out "${WORK_DIR}/straight.obj")
+    run_headless(--read-cache "${WORK_DIR}/run.cache" --out "${WORK_DIR}/played.obj")
+    expect_same("${WORK_DIR}/straight.obj" "${WORK_DIR}/played.obj")
+else()
+    message(FATAL_ERROR "Unknown MODE '${MODE}'")
+endif()
@@ -0,0 +1,43 @@
+# Sleep timing test for clothsim_headless, run by CTest:
+#
+#   cmake -DHEADLESS=<exe> -DARGS="<options>" -DWORK_DIR=<dir> -P SleepFramesTest.cmake
+#
+# A drape under very weak gravity (0.01 m/s²) creeps far slower than the
+# default --sleep-speed, so every tile is quiet from the first frame. It
+# must have no tile asleep after SLEEP_STEPS - 1 update() calls and every
+# tile asleep after SLEEP_STEPS, whatever the solver: XPBD substeps count
+# as one frame and share its drift budget.
+#
+# ARGS are the solver options given to both runs.
+
+if(NOT HEADLESS OR NOT WORK_DIR)
+    message(FATAL_ERROR "SleepFramesTest.cmake needs -DHEADLESS and -DWORK_DIR")
+endif()
+separate_arguments(args UNIX_COMMAND "${ARGS}")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+set(SLEEP_STEPS 30)
+
+# Runs `steps` frames and sets asleep / tiles from the "Sleeping:" line
+function(run_frames steps)
+    execute_process(COMMAND "${HEADLESS}" ${args} --gravity 0,-0.01,0 --sleep --sleep-steps ${SLEEP_STEPS}
+                            --steps ${steps} --out "${WORK_DIR}/drape.obj"
+                    RESULT_VARIABLE rc OUTPUT_VARIABLE out)
+    if(NOT rc EQUAL 0)
+        message(FATAL_ERROR "clothsim_headless ${ARGS} --steps ${steps} failed: ${rc}")
+    endif()
+    if(NOT out MATCHES "Sleeping: ([0-9]+) of ([0-9]+) tiles")
+        message(FATAL_ERROR "No sleep report in:\n${out}")
+    endif()
+    set(asleep ${CMAKE_MATCH_1} PARENT_SCOPE)
+    set(tiles  ${CMAKE_MATCH_2} PARENT_SCOPE)
+endfunction()
+
+math(EXPR before "${SLEEP_STEPS} - 1")
+run_frames(${before})
+if(NOT asleep EQUAL 0)
+    message(FATAL_ERROR "${ARGS}: ${asleep} of ${tiles} tiles asleep after ${before} frames, expected none")
+endif()
+run_frames(${SLEEP_STEPS})
+if(NOT asleep EQUAL tiles)
+    message(FATAL_ERROR "${ARGS}: ${asleep} of ${tiles} tiles asleep after ${SLEEP_STEPS} frames, expected all")
+endif()
@@ -0,0 +1,338 @@
+// clothsim_bench — per-phase microbenchmarks for Cloth::update.
+//
+// Times applyForces, integrate, satisfyConstraints, handleSphereCollision,
+// handleColliders (against a triangle-mesh sphere, --mesh-tris) and
+// handleSelfCollisions separately over a sweep of grid sizes and
+// constraint iteration counts, and reports ns/particle and ns/spring per
+// phase, plus the constraint sweeps actually run (satisfyConstraints stops
+// early at --tol). Use --csv to get machine-readable rows for CI tracking.
+// Each config reports the spring-kernel instantiation it ran (KernelFeature);
+// --generic-kernels runs the all-features one instead, to measure what the
+// specialisation buys.
+//
+// Example:
+//   clothsim_bench --sizes 32,64,128,256,512 --iters 1,8,32 --csv bench.csv
+//   clothsim_bench --sizes 256 --iters 8 --generic-kernels
+
+#include "Cloth.h"
+#include "ClothKernels.h"
+#include "Constants.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct Options
+    {
+        std::vector<int> sizes   = { 32, 64, 128, 256, 512 };
+        std::vector<int> iters   = { 1, 8, 32 };
+        float            tolerance = DEFAULT_CONSTRAINT_TOLERANCE;   ///< Cloth::constraintTolerance
+        bool             multigrid = false;   ///< Cloth::multigridConstraints
+        bool             generic   = false;   ///< Cloth::specializedKernels off
+        bool             wind      = false;   ///< Cloth::windEnabled
+        bool             unpinned  = false;   ///< Drop the two default corner pins
+        float            springDamping = DEFAULT_SPRING_DAMPING;
+        int              warmup  = 60;     ///< Settling steps before timing
+        double           minTime = 0.25;   ///< Seconds of timed steps per config
+        int              minReps = 5;
+        int              maxReps = 500;
+        int              threads = 0;      ///< 0 = hardware concurrency
+        std::string      isa;              ///< Empty = best available
+        ParticleLayout   layout  = ParticleLayout::Tiled;
+        int              meshTris = 100000; ///< Triangles in the mesh collider
+        std::string      csv;              ///< Empty = no CSV output
+    };
+
+    /// Phases timed individually, in pipeline order
+    enum Phase { Forces, Integrate, Constraints, Sphere, Colliders, SelfCollide, PhaseCount };
+
+    const char* phaseName(int p)
+    {
+        static const char* names[PhaseCount] = {
+            "applyForces", "integrate", "satisfyConstraints",
+            "handleSphereCollision", "handleColliders", "handleSelfCollisions"
+        };
+        return names[p];
+    }
+
+    /// Per-phase cost is normalized by what the phase loops over
+    bool perSpring(int p) { return p == Forces || p == Constraints; }
+
+    struct Result
+    {
+        int    size, iters, particles, springs, reps;
+        double medianNs[PhaseCount];
+        double meanSweeps;   ///< Constraint sweeps per step, out of iters
+        unsigned kernels;    ///< Cloth::getKernelFeatures()
+    };
+
+    std::vector<int> parseList(const std::string& text)
+    {
+        std::vector<int> out;
+        std::stringstream ss(text);
+        std::string item;
+        while (std::getline(ss, item, ','))
+            if (!item.empty()) out.push_back(std::atoi(item.c_str()));
+        return out;
+    }
+
+    /// UV sphere with at least `minTris` triangles, CCW from outside.
+    std::shared_ptr<MeshCollider> sphereMesh(glm::vec3 center, float radius, int minTris)
+    {
+        int stacks = 4;
+        while (2 * stacks * (2 * stacks) < minTris) ++stacks;
+        int slices = 2 * stacks;
+
+        const float pi = 3.14159265f;
+        std::vector<glm::vec3> vertices;
+        for (int i = 0; i <= stacks; ++i)
+        {
+            float theta = pi * i / stacks;
+            for (int j = 0; j < slices; ++j)
+            {
+                float phi = 2.f * pi * j / slices;
+                vertices.push_back(center + radius * glm::vec3(std::sin(theta) * std::cos(phi),
+                                                               std::cos(theta),
+                                                               std::sin(theta) * std::sin(phi)));
+            }
+        }
+        std::vector<glm::ivec3> triangles;
+        auto v = [slices](int i, int j) { return i * slices + j % slices; };
+        for (int i = 0; i < stacks; ++i)
+            for (int j = 0; j < slices; ++j)
+            {
+                triangles.push_back({ v(i, j), v(i, j + 1), v(i + 1, j) });
+                triangles.push_back({ v(i, j + 1), v(i + 1, j + 1), v(i + 1, j) });
+            }
+        return std::make_shared<MeshCollider>(std::move(vertices), std::move(triangles));
+    }
+
+    double median(std::vector<double>& v)
+    {
+        std::sort(v.begin(), v.end());
+        size_t n = v.size();
+        return n % 2 ? v[n / 2] : 0.5 * (v[n / 2 - 1] + v[n / 2]);
+    }
+
+    void printUsage(const char* exe)
+    {
+        std::cout <<
+            "Usage: " << exe << " [options]\n"
+            "  --sizes A,B,...   square grid sizes to sweep     (default 32,64,128,256,512)\n"
+            "  --iters A,B,...   constraintIters values to sweep (default 1,8,32)\n"
+            "  --tol F           constraint early-out tolerance, 0 = always iters\n"
+            "                    (default " << DEFAULT_CONSTRAINT_TOLERANCE << ")\n"
+            "  --multigrid       run the multigrid stretch pass in satisfyConstraints\n"
+            "  --wind            enable wind\n"
+            "  --spring-damping F  spring damping, 0 = off   (default " << DEFAULT_SPRING_DAMPING << ")\n"
+            "  --unpinned        no pinned corners\n"
+            "  --generic-kernels all-features spring kernels, as a baseline for the\n"
+            "                    ones specialised for the config (Cloth::specializedKernels)\n"
+            "  --warmup N        settling steps before timing   (default 60)\n"
+            "  --min-time S      timed seconds per config       (default 0.25)\n"
+            "  --threads N       solver threads, 0 = all        (default 0)\n"
+            "  --isa NAME        scalar | sse2 | avx2 | neon    (default: best available)\n"
+            "  --layout NAME     row-major | tiled              (default tiled)\n"
+            "  --mesh-tris N     triangles in the mesh collider (default 100000)\n"
+            "  --csv PATH        also write results as CSV\n";
+    }
+
+    /// Time one configuration: settle, then time each phase of every step.
+    Result runConfig(const Options& opt, ThreadPool& pool, int size, int iters)
+    {
+        const float dt = DEFAULT_DELTA_TIME;
+
+        Cloth cloth(size, size, CLOTH_SPACING);
+        cloth.setThreadPool(&pool);
+        cloth.constraintIters = iters;
+        cloth.constraintTolerance = opt.tolerance;
+        cloth.multigridConstraints = opt.multigrid;
+        cloth.specializedKernels = !opt.generic;
+        cloth.windEnabled     = opt.wind;
+        cloth.springDamping   = opt.springDamping;
+        cloth.particleLayout  = opt.layout;
+        cloth.reset();
+        if (opt.unpinned) cloth.unpinAll();
+
+        // Sphere under the middle of the cloth so the collision pass does real work
+        float     extent = (size - 1) * CLOTH_SPACING;
+        glm::vec3 center = { 0.f, extent * 0.5f, 0.f };
+        float     radius = extent * 0.2f;
+
+        // Same sphere again as a triangle mesh, for the BVH collider path.
+        // Slightly offset so the two passes don't just undo each other.
+        cloth.colliders.meshes.push_back(
+            sphereMesh(center + glm::vec3(0.f, -radius * 0.5f, 0.f), radius, opt.meshTris));
+
+        for (int i = 0; i < opt.warmup; ++i)
+            cloth.update(dt);
+
+        using clock = std::chrono::steady_clock;
+        std::vector<double> samples[PhaseCount];
+        double total = 0.0;
+        int    reps  = 0;
+        long   sweeps = 0;
+
+        auto timed = [&](int phase, auto&& fn) {
+            auto t0 = clock::now();
+            fn();
+            double ns = std::chrono::duration<double, std::nano>(clock::now() - t0).count();
+            samples[phase].push_back(ns);
+            total += ns * 1e-9;
+        };
+
+        while (reps < opt.maxReps && (reps < opt.minReps || total < opt.minTime))
+        {
+            // Same order as Cloth::update, plus the two collision passes
+            cloth.globalTime += dt;
+            timed(Forces,      [&] { cloth.applyForces(); });
+            timed(Integrate,   [&] { cloth.integrate(dt); });
+            timed(Constraints, [&] { cloth.satisfyConstraints(); });
+            sweeps += cloth.getConstraintIterations();
+            timed(Sphere,      [&] { cloth.handleSphereCollision(center, radius); });
+            timed(Colliders,   [&] { cloth.handleColliders(); });
+            timed(SelfCollide, [&] { cloth.handleSelfCollisions(); });
+            ++reps;
+        }
+
+        Result r;
+        r.size      = size;
+        r.iters     = iters;
+        r.particles = size * size;
+        r.springs   = (int)cloth.getSprings().size();
+        r.reps      = reps;
+        r.meanSweeps = reps > 0 ? (double)sweeps / reps : 0.0;
+        r.kernels    = cloth.getKernelFeatures();
+        for (int p = 0; p < PhaseCount; ++p)
+            r.medianNs[p] = median(samples[p]);
+        return r;
+    }
+}
+
+// MARK: - Main
+int main(int argc, char** argv)
+{
+    Options opt;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        auto next = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value for " << arg << "\n";
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+
+        if      (arg == "-h" || arg == "--help") { printUsage(argv[0]); return 0; }
+        else if (arg == "--sizes")    opt.sizes   = parseList(next());
+        else if (arg == "--iters")    opt.iters   = parseList(next());
+        else if (arg == "--tol")      opt.tolerance = (float)std::atof(next());
+        else if (arg == "--multigrid") opt.multigrid = true;
+        else if (arg == "--generic-kernels") opt.generic = true;
+        else if (arg == "--wind")     opt.wind    = true;
+        else if (arg == "--unpinned") opt.unpinned = true;
+        else if (arg == "--spring-damping") opt.springDamping = (float)std::atof(next());
+        else if (arg == "--warmup")   opt.warmup  = std::atoi(next());
+        else if (arg == "--min-time") opt.minTime = std::atof(next());
+        else if (arg == "--threads")  opt.threads = std::atoi(next());
+        else if (arg == "--isa")      opt.isa     = next();
+        else if (arg == "--csv")      opt.csv     = next();
+        else if (arg == "--mesh-tris") opt.meshTris = std::atoi(next());
+        else if (arg == "--layout") {
+            std::string name = next();
+            if      (name == "row-major") opt.layout = ParticleLayout::RowMajor;
+            else if (name == "tiled")     opt.layout = ParticleLayout::Tiled;
+            else {
+                std::cerr << "Unknown layout '" << name << "' (see --help)\n";
+                return 2;
+            }
+        }
+        else {
+            std::cerr << "Unknown option " << arg << " (see --help)\n";
+            return 2;
+        }
+    }
+
+    if (!opt.isa.empty())
+    {
+        using ClothKernels::Isa;
+        Isa isa;
+        if      (opt.isa == "scalar") isa = Isa::Scalar;
+        else if (opt.isa == "sse2")   isa = Isa::SSE2;
+        else if (opt.isa == "avx2")   isa = Isa::AVX2;
+        else if (opt.isa == "neon")   isa = Isa::NEON;
+        else {
+            std::cerr << "Unknown instruction set '" << opt.isa << "' (see --help)\n";
+            return 2;
+        }
+        if (!ClothKernels::setIsa(isa)) {
+            std::cerr << "Instruction set '" << opt.isa << "' is not supported on this machine\n";
+            return 2;
+        }
+    }
+
+    ThreadPool pool(opt.threads);
+    const char* layoutName = opt.layout == ParticleLayout::Tiled ? "tiled" : "row-major";
+    std::printf("clothsim_bench: %d thread(s), kernels %s, %s layout%s%s\n\n",
+                pool.size(), ClothKernels::isaName(ClothKernels::activeIsa()), layoutName,
+                opt.multigrid ? ", multigrid constraints" : "",
+                opt.generic ? ", generic spring kernels" : "");
+
+    std::vector<Result> results;
+    for (int size : opt.sizes)
+    {
+        for (int iters : opt.iters)
+        {
+            Result r = runConfig(opt, pool, size, iters);
+            results.push_back(r);
+
+            std::printf("%4d x %-4d iters=%-3d  particles=%-7d springs=%-8d reps=%d  sweeps=%.1f  kernels=%s\n",
+                        size, size, iters, r.particles, r.springs, r.reps, r.meanSweeps,
+                        Cloth::kernelFeatureNames(r.kernels).c_str());
+            double stepNs = 0.0;
+            for (int p = 0; p < PhaseCount; ++p)
+            {
+                stepNs += r.medianNs[p];
+                std::printf("  %-22s %10.3f us  %8.2f ns/particle",
+                            phaseName(p), r.medianNs[p] * 1e-3, r.medianNs[p] / r.particles);
+                if (perSpring(p))
+                    std::printf("  %8.2f ns/spring", r.medianNs[p] / r.springs);
+                std::printf("\n");
+            }
+            std::printf("  %-22s %10.3f us\n\n", "total", stepNs * 1e-3);
+        }
+    }
+
+    if (!opt.csv.empty())
+    {
+        std::FILE* f = std::fopen(opt.csv.c_str(), "w");
+        if (!f) {
+            std::cerr << "✗ Could not open " << opt.csv << " for writing\n";
+            return 1;
+        }
+        std::fprintf(f, "size,iters,particles,springs,threads,isa,layout,phase,median_ns,ns_per_particle,ns_per_spring,mean_sweeps,kernels\n");
+        for (const Result& r : results)
+            for (int p = 0; p < PhaseCount; ++p)
+                std::fprintf(f, "%d,%d,%d,%d,%d,%s,%s,%s,%.1f,%.4f,%.4f,%.2f,%s\n",
+                             r.size, r.iters, r.particles, r.springs, pool.size(),
+                             ClothKernels::isaName(ClothKernels::activeIsa()), layoutName, phaseName(p),
+                             r.medianNs[p], r.medianNs[p] / r.particles,
+                             r.medianNs[p] / r.springs, r.meanSweeps,
+                             Cloth::kernelFeatureNames(r.kernels).c_str());
+        std::fclose(f);
+        std::cout << "Wrote " << opt.csv << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,463 @@
+// clothsim_headless — batch cloth simulation without a window or GL context.
+//
+// Steps Cloth::update as fast as the CPU allows (no vsync) and writes the
+// drape to OBJ, either at the end or every N steps, and optionally the whole
+// sequence to a binary cache (ClothCache) for playback in the viewer.
+// Intended for render nodes without a GPU.
+//
+// Example:
+//   clothsim_headless --rows 100 --cols 100 --steps 2000 --dt 0.016
+//                     --stiffness 800 --out drape.obj --every 500
+//   clothsim_headless --steps 600 --cache drape.cache --cache-every 2 --cache-delta
+//   clothsim_headless --steps 200 --trace drape.trace.json
+
+#include "AllocCounter.h"
+#include "Cloth.h"
+#include "ClothCache.h"
+#include "ClothExport.h"
+#include "ClothWorld.h"
+#include "Constants.h"
+#include "Profiler.h"
+#include "ThreadPool.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct Options
+    {
+        int         rows    = CLOTH_ROWS;
+        int         cols    = CLOTH_COLS;
+        float       spacing = CLOTH_SPACING;
+        int         steps   = 1000;
+        float       dt      = DEFAULT_DELTA_TIME;
+        int         every   = 0;         ///< Write a frame every N steps (0 = final only)
+        int         threads = 0;         ///< 0 = hardware concurrency
+        int         cloths  = 1;         ///< Identical copies stepped together (ClothWorld)
+        ThreadPool::Affinity affinity = ThreadPool::Affinity::None;
+        std::string out     = "cloth.obj";
+        std::string cache;               ///< Binary cache path ("" = none)
+        int         cacheEvery = 1;      ///< Cache a frame every N steps
+        ClothCacheOptions cacheOptions;
+        std::string checkpoint;          ///< Checkpoint path ("" = none)
+        int         checkpointEvery = 0; ///< Also checkpoint every N steps (0 = final only)
+        std::string restore;             ///< Warm-start checkpoint ("" = fresh grid)
+        std::string readCache;           ///< Export this cache's last frame instead of simulating
+        std::string trace;               ///< Chrome trace path ("" = none)
+        int         traceSteps = 0;      ///< Steps traced from the start (0 = all)
+        bool        quiet   = false;
+        bool        checkAllocs = false; ///< Steps after the first must not allocate
+        int         lod     = 0;                 ///< Cloth::setLodLevel()
+    };
+
+    void printUsage(const char* exe)
+    {
+        std::cout <<
+            "Usage: " << exe << " [options]\n"
+            "\n"
+            "Grid and run:\n"
+            "  --rows N            particles vertically        (default " << CLOTH_ROWS << ")\n"
+            "  --cols N            particles horizontally      (default " << CLOTH_COLS << ")\n"
+            "  --spacing F         rest distance, meters       (default " << CLOTH_SPACING << ")\n"
+            "  --steps N           number of update() calls    (default 1000)\n"
+            "  --dt F              time step, seconds          (default " << DEFAULT_DELTA_TIME << ")\n"
+            "  --threads N         solver threads, 0 = all     (default 0)\n"
+            "  --affinity MODE     none | compact: pin worker i to the i-th allowed CPU\n"
+            "                      (default none; combine with taskset to share a node)\n"
+            "  --lod L             simulate at LOD level L, 0.." << LOD_MAX_LEVEL << " (default 0); output\n"
+            "                      stays at the simulated grid\n"
+            "  --cloths N          step N identical copies as one batch (default 1);\n"
+            "                      only the first is written\n"
+            "\n"
+            "Physics:\n"
+            "  --stiffness F       structural/shear stiffness\n"
+            "  --bend F            bending stiffness\n"
+            "  --spring-damping F  spring damping\n"
+            "  --air-damping F     air damping\n"
+            "  --max-stretch F     constraint upper bound factor\n"
+            "  --max-compress F    constraint lower bound factor\n"
+            "  --iters N           constraint iterations (mass-spring), at most\n"
+            "  --constraint-tol F  stop the iterations at this relative violation\n"
+            "                      (default " << DEFAULT_CONSTRAINT_TOLERANCE << ", 0 = always --iters)\n"
+            "  --multigrid         limit stretch on coarse grids first, so fine\n"
+            "                      cloth hangs taut in a few iterations\n"
+            "  --solver NAME       mass-spring | xpbd | implicit (default mass-spring)\n"
+            "  --substeps N        XPBD substeps per step\n"
+            "  --cg-tol F          implicit PCG relative tolerance\n"
+            "  --cg-iters N        implicit PCG iteration cap\n"
+            "  --gravity X,Y,Z     gravity vector\n"
+            "  --wind F            enable wind with this strength\n"
+            "  --wind-dir X,Y,Z    wind direction\n"
+            "  --self-collisions   run the self-collision pass every step\n"
+            "  --sleep             freeze tiles whose mean speed over --sleep-steps\n"
+            "                      steps stays below --sleep-speed; a hanging drape\n"
+            "                      keeps creeping, use --sleep-speed 0.05 to freeze it\n"
+            "  --sleep-speed F     rest threshold, m/s         (default " << DEFAULT_SLEEP_SPEED << ")\n"
+            "  --sleep-steps N     steps at rest before sleeping (default " << DEFAULT_SLEEP_STEPS << ")\n"
+            "\n"
+            "Colliders (repeatable):\n"
+            "  --sphere X,Y,Z,R    sphere collider\n"
+            "  --capsule AX,AY,AZ,BX,BY,BZ,R  capsule collider\n"
+            "  --plane NX,NY,NZ,D  half-space dot(n, x) < D is solid\n"
+            "  --mesh PATH         triangle mesh collider from an OBJ file\n"
+            "  --thickness F       collision thickness, meters (default " << DEFAULT_COLLISION_THICKNESS << ")\n"
+            "  --friction F        collision friction, 0..1    (default " << DEFAULT_COLLISION_FRICTION << ")\n"
+            "  --ccd               continuous collision (meshes and self) every step\n"
+            "  --ccd-iters N       self-CCD passes             (default " << DEFAULT_CCD_ITERATIONS << ")\n"
+            "\n"
+            "Output:\n"
+            "  --out PATH          final OBJ path              (default cloth.obj)\n"
+            "  --every N           also write PATH_<step>.obj every N steps\n"
+            "  --cache PATH        stream the first cloth to a binary cache (ClothCache)\n"
+            "  --cache-every N     cache the initial state and every N-th step (default 1)\n"
+            "  --cache-quantize    16-bit positions relative to each frame's bounds\n"
+            "  --cache-delta       quantised and delta-coded (implies --cache-quantize)\n"
+            "  --checkpoint PATH   save the full state of the first cloth to PATH at the end\n"
+            "  --checkpoint-every N  ... and every N steps (overwrites PATH)\n"
+            "  --restore PATH      start from a checkpoint instead of the initial grid;\n"
+            "                      physics options given here override its parameters\n"
+            "  --read-cache PATH   write the last frame of the cache PATH to --out and\n"
+            "                      exit, without simulating\n"
+            "  --trace PATH        write a Chrome trace (chrome://tracing, Perfetto) of the run\n"
+            "  --trace-steps N     ... of its first N steps only\n"
+            "  --check-allocs      fail if a step after the first allocates on any\n"
+            "                      thread (AllocCounter; not with --cache)\n"
+            "  --quiet             no progress output\n";
+    }
+
+    bool parseVec3(const char* text, glm::vec3& v)
+    {
+        return std::sscanf(text, "%f,%f,%f", &v.x, &v.y, &v.z) == 3;
+    }
+
+    /// "drape.obj", 500 → "drape_000500.obj"
+    std::string framePath(const std::string& out, int step)
+    {
+        char suffix[32];
+        std::snprintf(suffix, sizeof(suffix), "_%06d", step);
+        size_t dot = out.rfind('.');
+        if (dot == std::string::npos || out.find('/', dot) != std::string::npos)
+            return out + suffix + ".obj";
+        return out.substr(0, dot) + suffix + out.substr(dot);
+    }
+}
+
+// MARK: - Main
+int main(int argc, char** argv)
+{
+    Options opt;
+
+    // Physics overrides are applied after the Cloth exists, in order
+    struct Override { std::string key; std::string value; };
+    std::vector<Override> physics;
+    bool selfCollisions = false;
+
+    // ── Parse command line ───────────────────────────────────────────────────
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        auto next = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value for " << arg << "\n";
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+
+        if      (arg == "-h" || arg == "--help") { printUsage(argv[0]); return 0; }
+        else if (arg == "--rows")             opt.rows    = std::atoi(next());
+        else if (arg == "--cols")             opt.cols    = std::atoi(next());
+        else if (arg == "--spacing")          opt.spacing = (float)std::atof(next());
+        else if (arg == "--steps")            opt.steps   = std::atoi(next());
+        else if (arg == "--dt")               opt.dt      = (float)std::atof(next());
+        else if (arg == "--every")            opt.every   = std::atoi(next());
+        else if (arg == "--threads")          opt.threads = std::atoi(next());
+        else if (arg == "--cloths")           opt.cloths  = std::atoi(next());
+        else if (arg == "--affinity") {
+            std::string mode = next();
+            if      (mode == "none")    opt.affinity = ThreadPool::Affinity::None;
+            else if (mode == "compact") opt.affinity = ThreadPool::Affinity::Compact;
+            else {
+                std::cerr << "Unknown affinity '" << mode << "' (see --help)\n";
+                return 2;
+            }
+        }
+        else if (arg == "--out")              opt.out     = next();
+        else if (arg == "--quiet")            opt.quiet   = true;
+        else if (arg == "--lod")              opt.lod     = std::atoi(next());
+        else if (arg == "--checkpoint")       opt.checkpoint = next();
+        else if (arg == "--checkpoint-every") opt.checkpointEvery = std::atoi(next());
+        else if (arg == "--restore")          opt.restore = next();
+        else if (arg == "--read-cache")       opt.readCache = next();
+        else if (arg == "--trace")            opt.trace   = next();
+        else if (arg == "--trace-steps")      opt.traceSteps = std::atoi(next());
+        else if (arg == "--check-allocs")     opt.checkAllocs = true;
+        else if (arg == "--cache")            opt.cache   = next();
+        else if (arg == "--cache-every")      opt.cacheEvery = std::atoi(next());
+        else if (arg == "--cache-quantize")   opt.cacheOptions.quantize = true;
+        else if (arg == "--cache-delta")      opt.cacheOptions.delta    = true;
+        else if (arg == "--self-collisions")  selfCollisions = true;
+        else if (arg == "--ccd" || arg == "--sleep" || arg == "--multigrid") physics.push_back({ arg, "" });
+        else if (arg == "--stiffness" || arg == "--bend" || arg == "--spring-damping" ||
+                 arg == "--air-damping" || arg == "--max-stretch" || arg == "--max-compress" ||
+                 arg == "--iters" || arg == "--constraint-tol" || arg == "--gravity" || arg == "--wind" || arg == "--wind-dir" ||
+                 arg == "--solver" || arg == "--substeps" || arg == "--cg-tol" || arg == "--cg-iters" ||
+                 arg == "--sphere" || arg == "--capsule" || arg == "--plane" || arg == "--mesh" ||
+                 arg == "--thickness" || arg == "--friction" || arg == "--ccd-iters" ||
+                 arg == "--sleep-speed" || arg == "--sleep-steps")
+            physics.push_back({ arg, next() });
+        else {
+            std::cerr << "Unknown option " << arg << " (see --help)\n";
+            return 2;
+        }
+    }
+
+    if (opt.rows < 2 || opt.cols < 2 || opt.steps < 0 || opt.dt <= 0.f || opt.cloths < 1 ||
+        opt.cacheEvery < 1 || opt.lod < 0 || opt.lod > LOD_MAX_LEVEL) {
+        std::cerr << "Invalid grid size, step count, dt, cloth count, cache interval or LOD level\n";
+        return 2;
+    }
+
+    if (!opt.readCache.empty()) {
+        ClothCacheReader reader;
+        if (!reader.open(opt.readCache))
+            return 1;
+        if (reader.getFrameCount() == 0) {
+            std::cerr << "✗ " << opt.readCache << " has no frames\n";
+            return 1;
+        }
+        return writeCacheFrameObj(reader, reader.getFrameCount() - 1, opt.out) ? 0 : 1;
+    }
+
+    // ── Cloth ────────────────────────────────────────────────────────────────
+    ThreadPool pool(opt.threads, opt.affinity);
+    ClothWorld world;
+    world.setThreadPool(&pool);
+    Cloth& cloth = world.add(opt.rows, opt.cols, opt.spacing);
+
+    // Applied in command-line order; after a restore only the parameter
+    // options run again, so they override the checkpoint's values
+    auto applyPhysics = [&](bool colliders) -> int {
+        for (const auto& o : physics)
+        {
+            const char* v = o.value.c_str();
+            bool ok = true;
+            const bool isCollider = o.key == "--sphere" || o.key == "--capsule" ||
+                                    o.key == "--plane"  || o.key == "--mesh";
+            if (isCollider && !colliders) continue;
+            if      (o.key == "--stiffness")      cloth.springStiffness = (float)std::atof(v);
+            else if (o.key == "--bend")           cloth.bendStiffness   = (float)std::atof(v);
+            else if (o.key == "--spring-damping") cloth.springDamping   = (float)std::atof(v);
+            else if (o.key == "--air-damping")    cloth.airDamping      = (float)std::atof(v);
+            else if (o.key == "--max-stretch")    cloth.maxStretch      = (float)std::atof(v);
+            else if (o.key == "--max-compress")   cloth.maxCompress     = (float)std::atof(v);
+            else if (o.key == "--iters")          cloth.constraintIters = std::atoi(v);
+            else if (o.key == "--constraint-tol") cloth.constraintTolerance = (float)std::atof(v);
+            else if (o.key == "--multigrid")      cloth.multigridConstraints = true;
+            else if (o.key == "--substeps")       cloth.xpbdSubsteps    = std::atoi(v);
+            else if (o.key == "--cg-tol")         cloth.implicitTolerance = (float)std::atof(v);
+            else if (o.key == "--cg-iters")       cloth.implicitMaxIters  = std::atoi(v);
+            else if (o.key == "--thickness")      cloth.collisionThickness = (float)std::atof(v);
+            else if (o.key == "--friction")       cloth.collisionFriction  = (float)std::atof(v);
+            else if (o.key == "--ccd")            cloth.continuousCollisions = true;
+            else if (o.key == "--ccd-iters")      cloth.ccdIterations      = std::atoi(v);
+            else if (o.key == "--sleep")          cloth.sleepEnabled       = true;
+            else if (o.key == "--sleep-speed")    cloth.sleepSpeed         = (float)std::atof(v);
+            else if (o.key == "--sleep-steps")    cloth.sleepSteps         = std::atoi(v);
+            else if (o.key == "--sphere") {
+                SphereCollider s;
+                ok = std::sscanf(v, "%f,%f,%f,%f", &s.center.x, &s.center.y, &s.center.z, &s.radius) == 4;
+                if (ok) cloth.colliders.spheres.push_back(s);
+            }
+            else if (o.key == "--capsule") {
+                CapsuleCollider c;
+                ok = std::sscanf(v, "%f,%f,%f,%f,%f,%f,%f", &c.a.x, &c.a.y, &c.a.z,
+                                 &c.b.x, &c.b.y, &c.b.z, &c.radius) == 7;
+                if (ok) cloth.colliders.capsules.push_back(c);
+            }
+            else if (o.key == "--plane") {
+                PlaneCollider p;
+                ok = std::sscanf(v, "%f,%f,%f,%f", &p.normal.x, &p.normal.y, &p.normal.z, &p.offset) == 4
+                     && glm::length(p.normal) > 0.f;
+                if (ok) {
+                    p.normal = glm::normalize(p.normal);
+                    cloth.colliders.planes.push_back(p);
+                }
+            }
+            else if (o.key == "--mesh") {
+                std::vector<glm::vec3>  vertices;
+                std::vector<glm::ivec3> triangles;
+                if (!readObjMesh(o.value, vertices, triangles))
+                    return 1;
+                auto mesh = std::make_shared<MeshCollider>(std::move(vertices), std::move(triangles));
+                if (!opt.quiet)
+                    std::cout << "Mesh collider " << o.value << ": " << mesh->getTriangles().size()
+                              << " triangles, " << mesh->getBvh().nodeCount() << " BVH nodes\n";
+                cloth.colliders.meshes.push_back(std::move(mesh));
+            }
+            else if (o.key == "--solver") {
+                if      (o.value == "mass-spring") cloth.solverMode = SolverMode::MassSpring;
+                else if (o.value == "xpbd")        cloth.solverMode = SolverMode::XPBD;
+                else if (o.value == "implicit")    cloth.solverMode = SolverMode::Implicit;
+                else {
+                    std::cerr << "Unknown solver '" << o.value << "' (see --help)\n";
+                    return 2;
+                }
+            }
+            else if (o.key == "--gravity")        ok = parseVec3(v, cloth.gravity);
+            else if (o.key == "--wind-dir")       ok = parseVec3(v, cloth.windDirection);
+            else if (o.key == "--wind") {
+                cloth.windEnabled  = true;
+                cloth.windStrength = (float)std::atof(v);
+            }
+            if (!ok) {
+                std::cerr << "Malformed value for " << o.key << ": '" << o.value << "' (see --help)\n";
+                return 2;
+            }
+        }
+        return 0;
+    };
+    if (int code = applyPhysics(true))
+        return code;
+
+    // Rest lengths and pins come from the initial grid
+    cloth.reset();
+    cloth.setLodLevel(opt.lod);
+
+    // Warm start: grid, particles and parameters from the checkpoint, then
+    // the command line's parameter options on top
+    if (!opt.restore.empty()) {
+        if (!readClothCheckpoint(cloth, opt.restore))
+            return 1;
+        if (int code = applyPhysics(false))
+            return code;
+        cloth.wake();
+        opt.rows = cloth.getDisplayRows();
+        opt.cols = cloth.getDisplayCols();
+        opt.lod  = cloth.getLodLevel();
+        opt.spacing = cloth.getSpacing();
+        if (!opt.quiet)
+            std::cout << "Restored " << opt.restore << " at t=" << cloth.globalTime << " s\n";
+    }
+
+    // Copies overlap the first cloth but never interact with it; they only
+    // add work to the batch
+    for (int k = 1; k < opt.cloths; ++k)
+    {
+        Cloth& copy = world.add(opt.rows, opt.cols, opt.spacing);
+        copy.setParams(cloth.getParams());
+        copy.ccdIterations = cloth.ccdIterations;
+        copy.colliders     = cloth.colliders;
+        copy.setLodLevel(opt.lod);
+        if (!opt.restore.empty())
+            copy.restoreState(cloth.saveState());
+    }
+
+    if (!opt.quiet)
+        std::cout << "Simulating " << opt.rows << "x" << opt.cols << " cloth"
+                  << (opt.lod > 0 ? " at LOD " + std::to_string(opt.lod) + " (" +
+                                    std::to_string(cloth.getRows()) + "x" +
+                                    std::to_string(cloth.getCols()) + ")" : std::string())
+                  << (opt.cloths > 1 ? " × " + std::to_string(opt.cloths) : std::string()) << ", "
+                  << opt.steps << " steps, dt=" << opt.dt << ", "
+                  << pool.size() << " thread(s)\n";
+
+    // Frames are encoded and written on the cache's own thread
+    ClothCacheWriter cache;
+    if (!opt.cache.empty()) {
+        if (!cache.open(opt.cache, cloth, opt.cacheOptions))
+            return 1;
+        cache.write(cloth);
+    }
+
+    // One trace frame per step
+    if (!opt.trace.empty()) {
+        if (!CLOTHSIM_PROFILING)
+            std::cerr << "✗ --trace ignored: built with CLOTHSIM_PROFILING=OFF\n";
+        Profiler::setThreadName("main");
+        Profiler::beginTrace(opt.trace, opt.traceSteps > 0 ? opt.traceSteps : opt.steps);
+    }
+
+    // ── Run ──────────────────────────────────────────────────────────────────
+    using clock = std::chrono::steady_clock;
+    auto   start    = clock::now();
+    double simTime  = 0.0;      // time spent inside update(), excluding output
+    std::uint64_t stepAllocs = 0;   // --check-allocs: every thread, steps after the first
+
+    for (int step = 1; step <= opt.steps; ++step)
+    {
+        auto t0 = clock::now();
+        AllocCounter::Scope allocs(true);
+        world.update(opt.dt);
+        if (selfCollisions)
+            for (int k = 0; k < world.size(); ++k)
+                world[k].handleSelfCollisions();
+        if (step > 1 && !Profiler::isTracing())   // Trace events are allocated
+            stepAllocs += allocs.count();
+        simTime += std::chrono::duration<double>(clock::now() - t0).count();
+
+        if (cache.isOpen() && step % opt.cacheEvery == 0)
+            cache.write(cloth);
+
+        if (!opt.checkpoint.empty() && opt.checkpointEvery > 0 && step % opt.checkpointEvery == 0 &&
+            step != opt.steps && !writeClothCheckpoint(cloth, opt.checkpoint))
+            return 1;
+
+        if (opt.every > 0 && step % opt.every == 0 && step != opt.steps)
+        {
+            if (!writeClothObj(cloth, framePath(opt.out, step)))
+                return 1;
+            if (!opt.quiet)
+                std::cout << "  step " << step << " → " << framePath(opt.out, step) << "\n";
+        }
+        Profiler::endFrame();
+    }
+    if (Profiler::isTracing() && !Profiler::endTrace())
+        return 1;
+    if (opt.checkAllocs) {
+        if (!CLOTHSIM_ALLOC_COUNTER)
+            std::cerr << "✗ --check-allocs ignored: AllocCounter is only compiled into Debug builds with CLOTHSIM_ALLOC_COUNTER=ON\n";
+        else if (!opt.cache.empty())
+            std::cerr << "✗ --check-allocs ignored with --cache: its I/O thread allocates as the file grows\n";
+        else if (!AllocCounter::expectNone(stepAllocs, "steps after the first"))
+            return 1;
+        else if (!opt.quiet)
+            std::cout << "✓ No heap allocations after the first step\n";
+    }
+
+    if (!writeClothObj(cloth, opt.out))
+        return 1;
+    if (!opt.checkpoint.empty() && !writeClothCheckpoint(cloth, opt.checkpoint))
+        return 1;
+    const int cachedFrames = cache.getFrameCount();
+    if (!cache.close())
+        return 1;
+
+    double wall = std::chrono::duration<double>(clock::now() - start).count();
+    if (!opt.quiet)
+    {
+        double stepsPerSec = simTime > 0.0 ? opt.steps / simTime : 0.0;
+        std::printf("Done: %d steps in %.3f s (%.1f steps/s, %.2f ms/step), wrote %s\n",
+                    opt.steps, wall, stepsPerSec,
+                    opt.steps > 0 ? 1e3 * simTime / opt.steps : 0.0, opt.out.c_str());
+        if (!opt.cache.empty())
+            std::printf("Cache: %d frames → %s\n", cachedFrames, opt.cache.c_str());
+        if (cloth.sleepEnabled)
+            std::printf("Sleeping: %d of %d tiles\n", cloth.getSleepingTiles(), cloth.getTileCount());
+        if (cloth.continuousCollisions)
+            std::printf("CCD: %d contacts on the last step\n", cloth.getContinuousContacts());
+        if (cloth.solverMode != SolverMode::XPBD)
+            std::printf("Constraints: %d of %d sweeps on the last step (max violation %.2g)\n",
+                        cloth.getConstraintIterations(), cloth.constraintIters, cloth.getConstraintViolation());
+        if (cloth.solverMode == SolverMode::Implicit)
+            std::printf("Implicit: %d PCG iterations on the last step\n", cloth.getImplicitIterations());
+    }
+    return 0;
+}